@@ -176,6 +176,19 @@ ece391_vidmap (uint8_t** screen_start)
     return 0;
 }
 
+void*
+ece391_sbrk (int32_t increment)
+{
+    return sbrk (increment);
+}
+
+int32_t
+ece391_sched_deadline (int32_t period_us, int32_t budget_us)
+{
+    /* Linux schedules us as it sees fit */
+    return 0;
+}
+
 int32_t 
 ece391_read (int32_t fd, void* buf, int32_t nbytes)
 {
@@ -19,6 +19,8 @@ extern int32_t ece391_open (const uint8_t* filename);
 extern int32_t ece391_close (int32_t fd);
 extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
+extern void* ece391_sbrk (int32_t increment);
+extern int32_t ece391_sched_deadline (int32_t period_us, int32_t budget_us);
 
 #endif /* ECE391SYSCALL_H */
 
@@ -5,6 +5,9 @@
 
 #define NULL 0
 #define WAIT 100
+/* one frame per interrupt of the 32 Hz RTC, drawing one takes far less */
+#define FRAME_US 31250
+#define FRAME_BUDGET_US 2000
 uint8_t *vmem_base_addr;
 uint8_t *mp1_set_video_mode (void);
 void add_frames(uint8_t *, uint8_t *, int32_t);
@@ -18,13 +21,18 @@ uint8_t file1[] = "frame1.txt";
 extern int mp1_ioctl(unsigned long arg, unsigned long cmd);
 extern void mp1_rtc_tasklet(unsigned long trash);
 
-static struct mp1_blink_struct blink_array[80*25];
+static struct mp1_blink_struct* blink_array;
 
 int main(void)
 {
     int rtc_fd, ret_val, i, garbage;
     struct mp1_blink_struct blink_struct;
 
+    /* heap pages are only backed once the blink list reaches them */
+    blink_array = ece391_sbrk(sizeof(struct mp1_blink_struct)*80*25);
+    if(blink_array == (void*)-1) {
+        return -1;
+    }
     ece391_memset(blink_array, 0, sizeof(struct mp1_blink_struct)*80*25);
 
     if(mp1_set_video_mode() == NULL) {
@@ -37,6 +45,8 @@ int main(void)
 
     ret_val = 32;
     ret_val = ece391_write(rtc_fd, &ret_val, 4);
+    /* keep the frame rate under load, without a reservation we still run */
+    ece391_sched_deadline(FRAME_US, FRAME_BUDGET_US);
 
     for(i=0; i<WAIT; i++) {
         ece391_read(rtc_fd, &garbage, 4);
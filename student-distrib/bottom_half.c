@@ -0,0 +1,70 @@
+// deferred work for interrupt handlers
+// handlers only capture what the hardware gave them and queue it, a kernel
+// thread does the slow part with interrupts enabled
+
+#include "bottom_half.h"
+#include "systemcall.h"
+
+// ring of queued work, head is the next entry to run
+static bh_work_t bh_ring[BH_QUEUE_SIZE];
+static uint32_t bh_head, bh_tail;
+
+// the worker sleeps here while the ring is empty, its lock protects the ring
+static wait_queue_t bh_wq;
+
+// Description: body of the worker thread
+// Inputs: none
+// Outputs: none
+// Effects: runs queued work in order, sleeps when there is none
+static void bh_worker(void){
+    bh_work_t work;
+    uint32_t flags;
+
+    while(1){
+        spin_lock_irqsave(&bh_wq.lock, flags);
+        while(bh_head == bh_tail){
+            // bh_queue wakes us up again
+            wq_sleep(&bh_wq);
+        }
+        work = bh_ring[bh_head];
+        bh_head = (bh_head + 1) & (BH_QUEUE_SIZE - 1);
+        spin_unlock_irqrestore(&bh_wq.lock, flags);
+
+        work.func(work.data);
+    }
+}
+
+// Description: starts the worker thread
+// Inputs: none
+// Outputs: none
+// Effects: work queued before this runs once the worker is scheduled
+void bh_init(void){
+    wq_init(&bh_wq);
+    pcb_t* pcb = kthread_create(bh_worker, "kworker");
+    if(pcb != NULL){
+        sched_wakeup(pcb);
+    }
+}
+
+// Description: queues work for the worker
+// Inputs: func - function to run
+//         data - argument for func
+// Outputs: 0, or -1 if the queue is full
+// Effects: wakes the worker, safe to call from interrupt handlers
+int32_t bh_queue(bh_func_t func, uint32_t data){
+    uint32_t flags;
+    uint32_t next;
+
+    spin_lock_irqsave(&bh_wq.lock, flags);
+    next = (bh_tail + 1) & (BH_QUEUE_SIZE - 1);
+    if(next == bh_head){
+        spin_unlock_irqrestore(&bh_wq.lock, flags);
+        return -1;
+    }
+    bh_ring[bh_tail].func = func;
+    bh_ring[bh_tail].data = data;
+    bh_tail = next;
+    spin_unlock_irqrestore(&bh_wq.lock, flags);
+    wq_wake_all(&bh_wq);
+    return 0;
+}
@@ -0,0 +1,25 @@
+// bottom half header file
+#ifndef _BOTTOM_HALF_H
+#define _BOTTOM_HALF_H
+
+#include "types.h"
+
+// entries in the work queue, must be a power of two
+#define BH_QUEUE_SIZE 64
+
+// deferred work, called with the data the interrupt handler captured
+typedef void (*bh_func_t)(uint32_t data);
+
+typedef struct bh_work_t {
+    bh_func_t func;
+    uint32_t data;
+} bh_work_t;
+
+// starts the worker thread that runs queued work
+extern void bh_init(void);
+
+// queues work from an interrupt handler and wakes the worker
+// returns 0, or -1 if the queue is full and the work was dropped
+extern int32_t bh_queue(bh_func_t func, uint32_t data);
+
+#endif /* _BOTTOM_HALF_H */
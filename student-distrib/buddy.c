@@ -0,0 +1,283 @@
+// buddy allocator for physical page frames
+// process images, kernel stacks and page tables are all carved out of the
+// memory the boot loader reports, so the number of processes scales with RAM
+
+#include "buddy.h"
+#include "lib.h"
+#include "spinlock.h"
+
+#define MMAP_AVAILABLE 1
+#define KB_SHIFT 10
+#define ONE_MB 0x100000
+
+// bookkeeping for every frame below PHYS_MEM_LIMIT
+static page_frame_t frames[NUM_FRAMES];
+// first frame of the first free block of each order
+static int32_t free_list[MAX_ORDER + 1];
+static uint32_t free_count = 0;
+// protects everything above, every CPU allocates from the same lists
+static spinlock_t buddy_lock = SPINLOCK_INIT;
+
+// Description: pushes a block onto the free list for its order
+// Inputs: frame - first frame of the block, order - size of the block
+// Outputs: none
+// Effects: marks the block free
+static void free_list_push(int32_t frame, uint32_t order){
+    frames[frame].flags = FRAME_FREE;
+    frames[frame].order = order;
+    frames[frame].prev = NO_FRAME;
+    frames[frame].next = free_list[order];
+    if(free_list[order] != NO_FRAME){
+        frames[free_list[order]].prev = frame;
+    }
+    free_list[order] = frame;
+}
+
+// Description: unlinks a block from the free list for its order
+// Inputs: frame - first frame of the block
+// Outputs: none
+// Effects: marks the block as no longer free
+static void free_list_remove(int32_t frame){
+    uint32_t order = frames[frame].order;
+    if(frames[frame].prev != NO_FRAME){
+        frames[frames[frame].prev].next = frames[frame].next;
+    } else {
+        free_list[order] = frames[frame].next;
+    }
+    if(frames[frame].next != NO_FRAME){
+        frames[frames[frame].next].prev = frames[frame].prev;
+    }
+    frames[frame].flags = FRAME_RESERVED;
+}
+
+// Description: hands a range of physical memory to the allocator
+// Inputs: start, end - physical range, end is exclusive
+// Outputs: none
+// Effects: frees every whole page in the range that is above ALLOC_START
+static void buddy_add_range(uint32_t start, uint32_t end){
+    if(start < ALLOC_START){
+        start = ALLOC_START;
+    }
+    if(end > PHYS_MEM_LIMIT){
+        end = PHYS_MEM_LIMIT;
+    }
+    // only whole pages are usable
+    start = (start + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    end &= ~(PAGE_SIZE - 1);
+
+    for(; start < end; start += PAGE_SIZE){
+        // skip pages that hold a boot module
+        if(frames[start >> PAGE_SHIFT].order > MAX_ORDER){
+            continue;
+        }
+        free_pages(start, ORDER_4KB);
+    }
+}
+
+// Description: builds the free lists from the multiboot memory map
+// Inputs: mbi - multiboot information from the boot loader
+// Outputs: none
+// Effects: every available page between ALLOC_START and PHYS_MEM_LIMIT
+//          that is not a boot module becomes allocatable
+void buddy_init(multiboot_info_t* mbi){
+    int32_t i;
+    for(i = 0; i < NUM_FRAMES; i++){
+        frames[i].next = frames[i].prev = NO_FRAME;
+        frames[i].order = 0;
+        frames[i].flags = FRAME_RESERVED;
+        frames[i].refcount = 0;
+    }
+    for(i = 0; i <= MAX_ORDER; i++){
+        free_list[i] = NO_FRAME;
+    }
+
+    // boot modules (the file system image) must never be handed out
+    // mark them so buddy_add_range skips them
+    module_t* mod = (module_t*)mbi->mods_addr;
+    uint32_t addr;
+    for(i = 0; i < mbi->mods_count; i++, mod++){
+        for(addr = mod->mod_start & ~(PAGE_SIZE - 1); addr < mod->mod_end && addr < PHYS_MEM_LIMIT; addr += PAGE_SIZE){
+            frames[addr >> PAGE_SHIFT].order = MAX_ORDER + 1;
+        }
+    }
+
+    if(mbi->flags & (1 << 6)){
+        // use the full memory map when the boot loader gives us one
+        memory_map_t* mmap;
+        for(mmap = (memory_map_t*)mbi->mmap_addr;
+            (uint32_t)mmap < mbi->mmap_addr + mbi->mmap_length;
+            mmap = (memory_map_t*)((uint32_t)mmap + mmap->size + sizeof(mmap->size))){
+            // nothing above 4GB is reachable anyway
+            if(mmap->type != MMAP_AVAILABLE || mmap->base_addr_high != 0){
+                continue;
+            }
+            uint32_t end = mmap->base_addr_low + mmap->length_low;
+            if(mmap->length_high != 0 || end < mmap->base_addr_low){
+                end = PHYS_MEM_LIMIT;
+            }
+            buddy_add_range(mmap->base_addr_low, end);
+        }
+    } else if(mbi->flags & 1){
+        // otherwise mem_upper is the amount of memory above 1MB in KB
+        buddy_add_range(ONE_MB, ONE_MB + (mbi->mem_upper << KB_SHIFT));
+    }
+
+    // clear the module markers
+    for(i = 0; i < NUM_FRAMES; i++){
+        if(frames[i].order > MAX_ORDER){
+            frames[i].order = 0;
+        }
+    }
+}
+
+// Description: allocates a block of physically contiguous pages
+// Inputs: order - the block is 2^order pages
+// Outputs: physical address of the block, aligned to its size, or 0 on failure
+// Effects: splits larger blocks as needed
+uint32_t alloc_pages(uint32_t order){
+    uint32_t current;
+    int32_t frame;
+    uint32_t flags;
+
+    if(order > MAX_ORDER){
+        return 0;
+    }
+
+    spin_lock_irqsave(&buddy_lock, flags);
+    // find the smallest free block that is big enough
+    for(current = order; current <= MAX_ORDER; current++){
+        if(free_list[current] != NO_FRAME){
+            break;
+        }
+    }
+    if(current > MAX_ORDER){
+        spin_unlock_irqrestore(&buddy_lock, flags);
+        return 0;
+    }
+
+    frame = free_list[current];
+    free_list_remove(frame);
+
+    // give back the upper halves until the block is the right size
+    while(current > order){
+        current--;
+        free_list_push(frame + (1 << current), current);
+    }
+
+    frames[frame].flags = FRAME_ALLOCATED;
+    frames[frame].order = order;
+    frames[frame].refcount = 1;
+    free_count -= (1 << order);
+    spin_unlock_irqrestore(&buddy_lock, flags);
+
+    return (uint32_t)frame << PAGE_SHIFT;
+}
+
+// Description: gives a block back to the free lists
+// Inputs: frame - first frame of the block, order - order it was allocated with
+// Outputs: none
+// Effects: merges the block with its buddies as far as possible, buddy_lock must be held
+static void buddy_free(int32_t frame, uint32_t order){
+    int32_t buddy;
+
+    frames[frame].refcount = 0;
+    free_count += (1 << order);
+
+    while(order < MAX_ORDER){
+        buddy = frame ^ (1 << order);
+        if(buddy >= NUM_FRAMES || frames[buddy].flags != FRAME_FREE || frames[buddy].order != order){
+            break;
+        }
+        free_list_remove(buddy);
+        frames[buddy].order = 0;
+        frames[frame].order = 0;
+        if(buddy < frame){
+            frame = buddy;
+        }
+        order++;
+    }
+    free_list_push(frame, order);
+}
+
+// Description: frees a block from alloc_pages
+// Inputs: addr - physical address of the block, order - order it was allocated with
+// Outputs: none
+// Effects: merges the block with its buddies as far as possible
+void free_pages(uint32_t addr, uint32_t order){
+    int32_t frame = addr >> PAGE_SHIFT;
+    uint32_t flags;
+
+    if(addr == 0 || frame >= NUM_FRAMES || order > MAX_ORDER){
+        return;
+    }
+
+    spin_lock_irqsave(&buddy_lock, flags);
+    buddy_free(frame, order);
+    spin_unlock_irqrestore(&buddy_lock, flags);
+}
+
+// Description: takes another reference to an allocated block
+// Inputs: addr - physical address returned by alloc_pages
+// Outputs: none
+// Effects: the block is only freed once every reference is put
+void get_pages(uint32_t addr){
+    int32_t frame = addr >> PAGE_SHIFT;
+    uint32_t flags;
+    if(addr == 0 || frame >= NUM_FRAMES){
+        return;
+    }
+    spin_lock_irqsave(&buddy_lock, flags);
+    frames[frame].refcount++;
+    spin_unlock_irqrestore(&buddy_lock, flags);
+}
+
+// Description: drops a reference to an allocated block
+// Inputs: addr - physical address returned by alloc_pages, order - its size
+// Outputs: none
+// Effects: frees the block when the last reference goes away
+void put_pages(uint32_t addr, uint32_t order){
+    int32_t frame = addr >> PAGE_SHIFT;
+    uint32_t flags;
+    if(addr == 0 || frame >= NUM_FRAMES || order > MAX_ORDER){
+        return;
+    }
+    spin_lock_irqsave(&buddy_lock, flags);
+    if(frames[frame].refcount <= 1){
+        buddy_free(frame, order);
+    } else {
+        frames[frame].refcount--;
+    }
+    spin_unlock_irqrestore(&buddy_lock, flags);
+}
+
+// Description: counts the references to an allocated block
+// Inputs: addr - physical address returned by alloc_pages
+// Outputs: number of references, 0 for a free block
+// Effects: none
+uint32_t page_refcount(uint32_t addr){
+    int32_t frame = addr >> PAGE_SHIFT;
+    if(addr == 0 || frame >= NUM_FRAMES){
+        return 0;
+    }
+    return frames[frame].refcount;
+}
+
+// Description: looks up the size of an allocated block
+// Inputs: addr - physical address returned by alloc_pages
+// Outputs: order of the block, -1 if addr is not the start of an allocated block
+// Effects: none
+int32_t buddy_block_order(uint32_t addr){
+    int32_t frame = addr >> PAGE_SHIFT;
+    if(frame >= NUM_FRAMES || frames[frame].flags != FRAME_ALLOCATED){
+        return -1;
+    }
+    return frames[frame].order;
+}
+
+// Description: reports how much memory is left
+// Inputs: none
+// Outputs: number of free 4KB pages
+// Effects: none
+uint32_t buddy_free_count(){
+    return free_count;
+}
@@ -0,0 +1,62 @@
+// physical page frame allocator header file
+#ifndef _BUDDY_H
+#define _BUDDY_H
+
+#include "types.h"
+#include "multiboot.h"
+
+#define PAGE_SHIFT      12
+#define PAGE_SIZE       (1 << PAGE_SHIFT)
+// largest block is 2^MAX_ORDER pages = 4MB, which is also a large page
+#define MAX_ORDER       10
+
+// everything below this is the kernel, its boot stack and legacy video memory
+#define ALLOC_START     0x800000
+// only memory below the user page directory entry is direct-mapped by the kernel
+#define PHYS_MEM_LIMIT  0x08000000
+#define NUM_FRAMES      (PHYS_MEM_LIMIT >> PAGE_SHIFT)
+#define NO_FRAME        -1
+
+// frame flags
+#define FRAME_RESERVED  0x0 // not usable, or part of a larger block
+#define FRAME_FREE      0x1 // first frame of a free block
+#define FRAME_ALLOCATED 0x2 // first frame of an allocated block
+
+// common block sizes
+#define ORDER_4KB       0
+#define ORDER_8KB       1
+#define ORDER_4MB       MAX_ORDER
+
+// bookkeeping for one 4KB physical frame
+// the free lists are threaded through the first frame of each free block
+typedef struct page_frame_t {
+    int32_t next;
+    int32_t prev;
+    uint8_t order;
+    uint8_t flags;
+    uint16_t refcount;
+} page_frame_t;
+
+// builds the free lists from the multiboot memory map
+extern void buddy_init(multiboot_info_t* mbi);
+
+// allocates 2^order contiguous, naturally aligned pages
+// returns the physical address of the block, or 0 if there is no memory
+extern uint32_t alloc_pages(uint32_t order);
+
+// returns a block from alloc_pages to the free lists
+extern void free_pages(uint32_t addr, uint32_t order);
+
+// reference counting for blocks shared copy-on-write
+// alloc_pages hands out blocks with one reference, put_pages frees on the last one
+extern void get_pages(uint32_t addr);
+extern void put_pages(uint32_t addr, uint32_t order);
+extern uint32_t page_refcount(uint32_t addr);
+
+// order an allocated block was allocated with, -1 if it is not one
+extern int32_t buddy_block_order(uint32_t addr);
+
+// number of free 4KB pages
+extern uint32_t buddy_free_count();
+
+#endif /* _BUDDY_H */
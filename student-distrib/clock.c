@@ -0,0 +1,118 @@
+// monotonic clock
+// the TSC is measured against one PIT tick at boot, after that the time is
+// a read of the TSC and a multiply, no interrupt has to have happened
+// the conversion lives in the time page, where user programs do the same
+// multiply without a system call
+
+#include "clock.h"
+#include "lib.h"
+#include "schedule.h"
+
+time_page_t* time_page;
+
+// Description: starts PIT channel 2 on a one-shot count
+// Inputs: count - PIT clocks to count down, at most 0xFFFF
+// Outputs: none
+// Effects: channel 2 counts once its gate goes up, which happens last,
+//          channel 0 and its interrupt are not involved
+void pit_ch2_start(uint32_t count){
+    uint8_t ctrl = inb(PIT_CH2_CTRL) & ~(PIT_CH2_GATE | PIT_CH2_SPEAKER);
+
+    outb(ctrl, PIT_CH2_CTRL);
+    outb(PIT_CH2_ONESHOT, PIT_CMD_PORT);
+    outb(count & 0xFF, PIT_CH2_DATA);
+    outb((count >> 8) & 0xFF, PIT_CH2_DATA);
+    outb(ctrl | PIT_CH2_GATE, PIT_CH2_CTRL);
+}
+
+// Description: waits for channel 2 to run out
+// Inputs: none
+// Outputs: none
+// Effects: busy waits, its output rises at zero, then the gate goes down again
+void pit_ch2_wait(void){
+    uint8_t ctrl;
+
+    while(!((ctrl = inb(PIT_CH2_CTRL)) & PIT_CH2_OUT));
+    outb(ctrl & ~PIT_CH2_GATE, PIT_CH2_CTRL);
+}
+
+// Description: turns a number of TSC cycles into nanoseconds
+// Inputs: cycles - cycles to convert
+// Outputs: the nanoseconds they take
+// Effects: the two halves are scaled apart so nothing overflows 64 bits
+static uint64_t cycles_to_ns(uint64_t cycles){
+    uint64_t lo = (uint64_t)(uint32_t)cycles * time_page->mult;
+    uint64_t hi = (uint64_t)(uint32_t)(cycles >> 32) * time_page->mult;
+
+    return (hi << (CLOCK_MAX_SHIFT - time_page->shift)) + (lo >> time_page->shift);
+}
+
+// Description: measures the TSC and starts the clock
+// Inputs: none
+// Outputs: none
+// Effects: busy waits one tick on PIT channel 2, call it with interrupts off
+//          so nothing stretches the measurement, without a usable result
+//          the clock falls back to counting PIT ticks, page_init must
+//          have set up the time page
+void clock_init(void){
+    uint64_t start, end, base;
+    uint32_t shift;
+
+    time_page = (time_page_t*)(time_table[0].addy << SHIFT_12);
+    time_page->ticks = pit_ticks;
+
+    pit_ch2_start(COUNT);
+    start = rdtsc();
+    pit_ch2_wait();
+    end = rdtsc();
+
+    // a TSC that far off is not one we can use
+    if((end - start) >> 32 != 0 || end == start){
+        time_page->tsc_per_tick = 0;
+        return;
+    }
+    time_page->tsc_per_tick = (uint32_t)(end - start);
+
+    // as many fraction bits as still leave the factor in 32 bits, there are
+    // fewer than 32 only on a TSC slower than a GHz
+    shift = CLOCK_MAX_SHIFT;
+    while((NS_PER_TICK >> (CLOCK_MAX_SHIFT - shift)) >= time_page->tsc_per_tick){
+        shift--;
+    }
+    time_page->shift = shift;
+    time_page->mult = div64_32((uint64_t)NS_PER_TICK << shift, time_page->tsc_per_tick, NULL);
+    base = rdtsc();
+    time_page->tsc_base_lo = (uint32_t)base;
+    time_page->tsc_base_hi = (uint32_t)(base >> 32);
+}
+
+// Description: publishes the tick count in the time page
+// Inputs: none
+// Outputs: none
+// Effects: one aligned store, a reader never sees half of it
+void clock_tick(void){
+    time_page->ticks = pit_ticks;
+}
+
+// Description: gets the time since clock_init
+// Inputs: none
+// Outputs: nanoseconds since then
+// Effects: every CPU's TSC is taken to run in step with the boot CPU's, which
+//          holds on anything with an invariant TSC
+uint64_t clock_ns(void){
+    uint64_t base;
+
+    if(time_page->tsc_per_tick == 0){
+        return (uint64_t)pit_ticks * NS_PER_TICK;
+    }
+    base = ((uint64_t)time_page->tsc_base_hi << 32) | time_page->tsc_base_lo;
+    return cycles_to_ns(rdtsc() - base);
+}
+
+// Description: splits a time into seconds and nanoseconds
+// Inputs: ns - the time in nanoseconds, less than 136 years
+//         ts - where to put it
+// Outputs: none
+void ns_to_timespec(uint64_t ns, timespec_t* ts){
+    ts->sec = div64_32(ns, NS_PER_SEC, &ts->nsec);
+}
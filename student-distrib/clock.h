@@ -0,0 +1,74 @@
+// monotonic clock header file
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+#include "types.h"
+#include "timer.h"
+#include "paging.h"
+
+// PIT channel 2 measures how fast other clocks run, its gate and output are in port 0x61
+#define PIT_CH2_DATA        0x42
+#define PIT_CMD_PORT        0x43
+#define PIT_CH2_ONESHOT     0xB0 // 1011 0000 selects channel 2 and mode 0
+#define PIT_CH2_CTRL        0x61
+#define PIT_CH2_GATE        0x01
+#define PIT_CH2_SPEAKER     0x02
+#define PIT_CH2_OUT         0x20
+
+#define NS_PER_SEC      1000000000
+#define NS_PER_US       1000
+// length of one PIT tick, which the TSC is measured against
+#define NS_PER_TICK     (NS_PER_SEC / PIT_HZ)
+// widest fixed point the cycles to nanoseconds factor can use
+#define CLOCK_MAX_SHIFT 32
+
+// clocks clock_gettime knows, time since boot is the only one
+#define CLOCK_MONOTONIC 0
+
+typedef struct timespec_t {
+    uint32_t sec;
+    // always less than NS_PER_SEC
+    uint32_t nsec;
+} timespec_t;
+
+// every process sees the time page here, read-only, so it can tell the time
+// without a system call, the layout is part of the user interface
+#define USER_TIME_PAGE  0x08C00000
+#define TIME_IDX        (USER_TIME_PAGE >> SHIFT_22)
+
+typedef struct time_page_t {
+    // PIT ticks since boot, pit_ticks as of the last tick
+    volatile uint32_t ticks;
+    // TSC cycles in one PIT tick, 0 if clock_init could not measure it,
+    // then the time is ticks * NS_PER_TICK
+    uint32_t tsc_per_tick;
+    // nanoseconds since boot = (TSC - tsc_base) * mult >> shift,
+    // none of these change once clock_init has run
+    uint32_t tsc_base_lo;
+    uint32_t tsc_base_hi;
+    uint32_t mult;
+    uint32_t shift;
+} time_page_t;
+
+// the time page as the kernel sees it, through the direct map
+extern time_page_t* time_page;
+
+// starts PIT channel 2 counting down count clocks, it does not interrupt
+extern void pit_ch2_start(uint32_t count);
+
+// busy waits until channel 2 reaches zero and stops it
+extern void pit_ch2_wait(void);
+
+// measures the TSC against the PIT, must run before anyone asks the time
+extern void clock_init(void);
+
+// copies pit_ticks to the time page, called by timer_advance
+extern void clock_tick(void);
+
+// nanoseconds since clock_init, never goes backwards
+extern uint64_t clock_ns(void);
+
+// splits nanoseconds into seconds and nanoseconds
+extern void ns_to_timespec(uint64_t ns, timespec_t* ts);
+
+#endif /* _CLOCK_H */
@@ -3,8 +3,10 @@
 #include "types.h"
 #include "lib.h"
 
-// declare array for file descriptors
-file_descriptor_t file_descriptor_array[FILE_DESCRIPTOR_ARRAY_SIZE];
+// where the boot block, inodes and data blocks of the file system are
+boot_block_t * boot_block_ptr;
+inode_t * inode_ptr;
+dblock_t * dblock_ptr;
 
 // Description: Initializes the file system.
 // Inputs: fs_start - Pointer to the start of the file system.
@@ -17,19 +19,6 @@ void fileSystem_init(uint32_t* fs_start) {
     inode_ptr = (inode_t*) boot_block_ptr + 1;
     // Set the data block pointer to the location immediately after the inodes
     dblock_ptr = (dblock_t*) inode_ptr + boot_block_ptr->inode_count;
-
-    int i;
-    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++){
-        file_descriptor_array[i].inode = 0;
-        file_descriptor_array[i].file_position = 0;
-        file_descriptor_array[i].flags = CLOSE;
-    }
-
-    // we want to open stdin and stdout on initialization
-    // open stdin
-    file_descriptor_array[0].flags = OPEN;
-    // open stdout
-    file_descriptor_array[1].flags = OPEN;
 }
 
 // Description: Reads directory entry by name.
@@ -139,23 +128,17 @@ int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t len) {
 
 
 // Description: Reads data from a file.
-// Inputs: fd - File descriptor, buf - Buffer to store data, nbytes - Number of bytes to read.
+// Inputs: file - descriptor of the open file, buf - Buffer to store data, nbytes - Number of bytes to read.
 // Outputs: Returns number of bytes read.
-// Effects: Reads data from a file into a buffer and updates the current file position.
-int32_t file_read(int32_t fd, void* buf, int32_t nbytes) {
-    // check for valid file
-    // if the file is not valid, just return 0 
-    // 0 bytes read
-    if(fd > MAX_FD || fd < MIN_FD){
-        return 0;
-    }
+// Effects: Reads data from a file into a buffer and updates the file position in the descriptor.
+int32_t file_read(file_descriptor_t* file, void* buf, int32_t nbytes) {
     // Clear the buffer
     memset(buf, '\0', nbytes);    
     // Read data from the file
-    unsigned int num_bytes_read = read_data(file_descriptor_array[fd].inode, file_descriptor_array[fd].file_position, buf, nbytes);
+    unsigned int num_bytes_read = read_data(file->inode, file->file_position, buf, nbytes);
 
     // update the file descriptor with the new file position
-    file_descriptor_array[fd].file_position += num_bytes_read;
+    file->file_position += num_bytes_read;
 
     // Return the number of bytes read
     return num_bytes_read;
@@ -171,67 +154,30 @@ int32_t file_write(int32_t fd, const void* buf, int32_t nbytes) {
 
 // Description: Opens a file.
 // Inputs: filename - Name of the file to open.
-// Outputs: Returns opened fd, -1 on failure.
-// Effects: Sets up global variables for the opened file's inode number and initial position.
+// Outputs: Returns 0, -1 on failure.
+// Effects: None, the open system call fills in the process's descriptor
 int32_t file_open(const uint8_t* filename) {
-    // Read the directory entry for the file
     dentry_t curr_dentry;
-    if (read_dentry_by_name(filename, &curr_dentry) == -1) return -1;
-
-    // look for the first unused file descriptor
-    int i, free_fd;
-    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++){
-        if(file_descriptor_array[i].flags == CLOSE){
-            free_fd = i;
-            break;
-        }
-    }
-
-    // check for valid file
-    // if the file is not valid, just fail (return -1)
-    if(free_fd > MAX_FD || free_fd < MIN_FD){
-        return -1;
-    }
-
-    // Set the file descriptor inode number for the file
-    file_descriptor_array[free_fd].inode = (curr_dentry.filetype == REG_FILE_NUM) ? curr_dentry.inode_num : 0;
-    // Reset the file descriptor file position
-    file_descriptor_array[free_fd].file_position = 0;
-    // Return success
-    return free_fd;
+    return (read_dentry_by_name(filename, &curr_dentry) == -1) ? -1 : 0;
 }
 
 // Description: Closes a file.
 // Inputs: fd - File descriptor.
 // Outputs: Returns 0
+// Effects: None, the close system call marks the process's descriptor closed
 int32_t file_close(int32_t fd) {
-    // check if valid file descriptor
-    // if so, close the current file
-    // user does not have access to close stdin or stdout
-    // which are at fd = 0 and 1 respectively
-    if(fd > MIN_FD + 1 && fd <FILE_DESCRIPTOR_ARRAY_SIZE){
-        file_descriptor_array[fd].flags = CLOSE;
-        return 0;
-    }
-    // if not a valid file, fail
-    return -1;
+    return 0;
 }
 
 
 // Description: Reads a directory entry.
-// Inputs: fd - File descriptor, buf - Buffer to store directory entry name, nbytes - Number of bytes to read.
+// Inputs: file - descriptor of the open directory, buf - Buffer to store directory entry name, nbytes - Number of bytes to read.
 // Outputs: Returns length of directory entry name read.
-// Effects: Reads the name of a directory entry into a buffer and updates the global directory position.
-int32_t dir_read(int32_t fd, void* buf, int32_t nbytes) {
-    // check for valid file
-    // if the file is not valid, just fail (return -1)
-    if(fd > MAX_FD || fd < MIN_FD){
-        return -1;
-    }
-
-    // Read the directory entry at the current global file position
+// Effects: Reads the name of a directory entry into a buffer and moves the descriptor to the next entry.
+int32_t dir_read(file_descriptor_t* file, void* buf, int32_t nbytes) {
+    // Read the directory entry at the descriptor's position
     dentry_t curr_dentry;
-    if (read_dentry_by_index(file_descriptor_array[fd].file_position++, &curr_dentry) == -1) return 0;
+    if (read_dentry_by_index(file->file_position++, &curr_dentry) == -1) return 0;
 
     // Clear the buffer
     memset(buf, '\0', nbytes);
@@ -259,8 +205,8 @@ int32_t dir_write(int32_t fd, const void* buf, int32_t nbytes) {
 
 // Description: Opens a directory.
 // Inputs: filename - Name of the directory to open.
-// Outputs: Returns opened fd, -1 on failure.
-// Effects: Sets up global variables for the opened directory's inode number and initial position.
+// Outputs: Returns 0, -1 on failure or if it is not a directory.
+// Effects: None, the open system call fills in the process's descriptor
 int32_t dir_open(const uint8_t* filename) {
     // Check if filename is NULL
     if (filename == 0) return -1;
@@ -269,43 +215,12 @@ int32_t dir_open(const uint8_t* filename) {
     dentry_t curr_dentry;
     if (read_dentry_by_name((uint8_t*) filename, &curr_dentry) == -1) return -1;
 
-    // look for the first unused file descriptor
-    int i, free_fd;
-    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++){
-        if(file_descriptor_array[i].flags == CLOSE){
-            free_fd = i;
-            break;
-        }
-    }
-
-    // check for valid file
-    // if the file is not valid, just fail (return -1)
-    if(free_fd > MAX_FD || free_fd < MIN_FD){
-        return -1;
-    }
-
-     // Set the descriptor inode number for the directory
-     file_descriptor_array[free_fd].inode = (curr_dentry.filetype == 1) ? 0 : -1;
-
-     // Reset the descriptor file position
-     file_descriptor_array[free_fd].file_position = 0;
-
-     // Return success or failure based on whether inode number is valid or not
-     return (file_descriptor_array[free_fd].inode == -1) ? -1 : free_fd;
+    return (curr_dentry.filetype == 1) ? 0 : -1;
 }
 
 // Description: Closes a directory. Currently does nothing.
 // Inputs: fd - File descriptor.
 // Outputs: Returns 0
 int32_t dir_close(int32_t fd) {
-    // check if valid file descriptor
-    // if so, close the current file
-    // user does not have access to close stdin or stdout
-    // which are at fd = 0 and 1 respectively
-    if(fd > MIN_FD + 1 && fd <FILE_DESCRIPTOR_ARRAY_SIZE){
-        file_descriptor_array[fd].flags = CLOSE;
-        return 0;
-    }
-    // if not a valid file descriptor, fail
-    return -1;
+    return 0;
 }
@@ -53,9 +53,12 @@ typedef struct dblock_t {
     char data[DATA_BLOCK_SIZE];
 } dblock_t;
 
+struct file_descriptor_t;
+
+// read gets the caller's own descriptor, it may sleep while others use theirs
 typedef struct fops_table_t { 
     int32_t (*open)(const uint8_t* filename);
-    int32_t (*read)(int32_t fd, void* buf, int32_t nbytes);
+    int32_t (*read)(struct file_descriptor_t* file, void* buf, int32_t nbytes);
     int32_t (*write)(int32_t fd, const void* buf, int32_t nbytes);
     int32_t (*close)(int32_t fd);
 } fops_table_t;
@@ -70,14 +73,11 @@ typedef struct file_descriptor_t {
 
 extern fops_table_t fops_table[NUM_DEVICES];
 
-// file descriptor array
-extern file_descriptor_t file_descriptor_array[FILE_DESCRIPTOR_ARRAY_SIZE];
-
 // we want to store pointers to given memory locations
 // split up into boot block, inodes, and data blocks
-boot_block_t * boot_block_ptr;
-inode_t * inode_ptr;
-dblock_t * dblock_ptr;
+extern boot_block_t * boot_block_ptr;
+extern inode_t * inode_ptr;
+extern dblock_t * dblock_ptr;
 
 // initializes the file system
 extern void fileSystem_init(uint32_t* fs_start);
@@ -90,14 +90,14 @@ extern int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t
 
 // helper functions for file system calls
 // read, write, open, close args are based on system call function defs
-extern int32_t file_read(int32_t fd, void* buf, int32_t nbytes);
+extern int32_t file_read(file_descriptor_t* file, void* buf, int32_t nbytes);
 extern int32_t file_write(int32_t fd, const void* buf, int32_t nbytes);
 extern int32_t file_open(const uint8_t* filename);
 extern int32_t file_close(int32_t fd);
 
 // helper functions for directory system calls
 // read, write, open, close args are based on system call function defs
-extern int32_t dir_read(int32_t fd, void* buf, int32_t nbytes);
+extern int32_t dir_read(file_descriptor_t* file, void* buf, int32_t nbytes);
 extern int32_t dir_write(int32_t fd, const void* buf, int32_t nbytes);
 extern int32_t dir_open(const uint8_t* filename);
 extern int32_t dir_close(int32_t fd);
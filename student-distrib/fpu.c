@@ -0,0 +1,221 @@
+// lazy FPU and SSE state switching
+// a switch only sets CR0.TS, the registers are saved and loaded by the #NM
+// handler when a process really uses them, so processes that never touch
+// floating point never pay for it
+// with more than one CPU a process may move before it uses the FPU again, so
+// registers it changed are saved when it is switched out, only the load is lazy
+
+#include "fpu.h"
+#include "lib.h"
+#include "slab.h"
+#include "idt.h"
+#include "systemcall.h"
+#include "smp.h"
+
+// FPU_STATE_SIZE objects, KMEM_ALIGN keeps them aligned for fxsave
+static kmem_cache_t* fpu_cache;
+// fxsave/fxrstor if the CPU has them, fnsave/frstor otherwise
+static uint8_t has_fxsr;
+// state right after fninit, every process starts from a copy of it
+static uint8_t fpu_init_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
+
+// Description: sets CR0.TS, the next FPU instruction raises #NM
+// Inputs: none
+// Outputs: none
+static void stts(){
+    uint32_t cr0;
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+    if(!(cr0 & CR0_TS)){
+        asm volatile("movl %0, %%cr0" : : "r"(cr0 | CR0_TS));
+    }
+}
+
+// Description: saves the FPU registers
+// Inputs: area - FPU_STATE_SIZE bytes, 16 byte aligned
+// Outputs: none
+// Effects: fnsave also resets the FPU
+static void fpu_save(uint8_t* area){
+    if(has_fxsr){
+        asm volatile("fxsave (%0)" : : "r"(area) : "memory");
+    } else {
+        asm volatile("fnsave (%0)" : : "r"(area) : "memory");
+    }
+}
+
+// Description: loads the FPU registers
+// Inputs: area - state saved by fpu_save
+// Outputs: none
+static void fpu_restore(const uint8_t* area){
+    if(has_fxsr){
+        asm volatile("fxrstor (%0)" : : "r"(area) : "memory");
+    } else {
+        asm volatile("frstor (%0)" : : "r"(area) : "memory");
+    }
+}
+
+// Description: turns on the FPU and, if the CPU has it, SSE on the calling CPU
+// Inputs: none
+// Outputs: none
+// Effects: the FPU is reset, leaves CR0.TS clear
+static void fpu_enable(void){
+    uint32_t eax, ebx, ecx, edx, cr0, cr4;
+
+    asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+    has_fxsr = (edx & CPUID_FXSR) != 0;
+
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    asm volatile("movl %0, %%cr0" : : "r"(cr0));
+
+    asm volatile("movl %%cr4, %0" : "=r"(cr4));
+    if(has_fxsr){
+        cr4 |= CR4_OSFXSR;
+    }
+    if(edx & CPUID_SSE){
+        cr4 |= CR4_OSXMMEXCPT;
+    }
+    asm volatile("movl %0, %%cr4" : : "r"(cr4));
+
+    asm volatile("fninit");
+}
+
+// Description: turns on the FPU and, if the CPU has it, SSE
+// Inputs: none
+// Outputs: none
+// Effects: must run after kmem_init, leaves CR0.TS set
+void fpu_init(void){
+    fpu_enable();
+    fpu_save(fpu_init_state);
+    fpu_cache = kmem_cache_create((int8_t*)"fpu_state", FPU_STATE_SIZE);
+    stts();
+}
+
+// Description: turns on the FPU of a CPU started after the boot CPU
+// Inputs: none
+// Outputs: none
+// Effects: leaves CR0.TS set, nobody's state is in the registers
+void fpu_cpu_init(void){
+    fpu_enable();
+    this_cpu()->fpu_owner = NULL;
+    stts();
+}
+
+// Description: decides whether the next process may use the FPU registers as they are
+// Inputs: prev - process being switched away from
+//         next - process about to run
+// Outputs: none
+// Effects: called by schedule with interrupts off, with more than one CPU
+//          the registers prev changed are saved now since it may run elsewhere next
+void fpu_switch(pcb_t* prev, pcb_t* next){
+    cpu_t* cpu = this_cpu();
+    uint32_t cr0;
+
+    if(nr_cpus > 1 && cpu->fpu_owner == prev){
+        asm volatile("movl %%cr0, %0" : "=r"(cr0));
+        // TS still set means prev did not touch the FPU since its state was loaded
+        if(!(cr0 & CR0_TS)){
+            fpu_save(prev->fpu_state);
+            // fnsave resets the FPU, the registers are nobody's anymore
+            if(!has_fxsr){
+                cpu->fpu_owner = NULL;
+            }
+        }
+    }
+    if(next == cpu->fpu_owner && next->fpu_cpu == cpu->id){
+        asm volatile("clts");
+    } else {
+        stts();
+    }
+}
+
+// Description: handles the first FPU instruction after a switch
+// Inputs: none
+// Outputs: none
+// Effects: saves the previous owner's registers and loads the running process's,
+//          the instruction is retried after the iret
+void fpu_nm_handler(void){
+    uint32_t flags;
+    cpu_t* cpu;
+    pcb_t* pcb = current_pcb();
+
+    // the kernel never uses the FPU, only a process can get here
+    if(pcb == NULL){
+        exception_handler(7);
+        return;
+    }
+    // first use, start from a clean FPU
+    if(pcb->fpu_state == NULL){
+        pcb->fpu_state = kmem_cache_alloc(fpu_cache);
+        if(pcb->fpu_state == NULL){
+            exception_handler(7);
+            return;
+        }
+        memcpy(pcb->fpu_state, fpu_init_state, FPU_STATE_SIZE);
+    }
+
+    cli_and_save(flags);
+    cpu = this_cpu();
+    asm volatile("clts");
+    if(cpu->fpu_owner != pcb || pcb->fpu_cpu != cpu->id){
+        // with more than one CPU fpu_switch already saved the owner
+        if(cpu->fpu_owner != NULL && cpu->fpu_owner != pcb && nr_cpus == 1){
+            fpu_save(cpu->fpu_owner->fpu_state);
+        }
+        fpu_restore(pcb->fpu_state);
+        cpu->fpu_owner = pcb;
+        pcb->fpu_cpu = cpu->id;
+    }
+    restore_flags(flags);
+}
+
+// Description: copies the FPU state of a process into a forked child
+// Inputs: child - new process without FPU state
+//         parent - running process
+// Outputs: 0, or -1 if out of memory
+// Effects: a parent that never used the FPU gives the child none either
+int32_t fpu_fork(pcb_t* child, pcb_t* parent){
+    uint32_t flags;
+    cpu_t* cpu;
+
+    if(parent->fpu_state == NULL){
+        return 0;
+    }
+    child->fpu_state = kmem_cache_alloc(fpu_cache);
+    if(child->fpu_state == NULL){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    cpu = this_cpu();
+    // the parent's live registers are newer than its saved state
+    if(cpu->fpu_owner == parent && parent->fpu_cpu == cpu->id){
+        asm volatile("clts");
+        fpu_save(parent->fpu_state);
+        if(!has_fxsr){
+            fpu_restore(parent->fpu_state);
+        }
+    }
+    restore_flags(flags);
+    memcpy(child->fpu_state, parent->fpu_state, FPU_STATE_SIZE);
+    return 0;
+}
+
+// Description: frees the FPU state of a process
+// Inputs: pcb - process that is going away
+// Outputs: none
+// Effects: the FPU registers belong to nobody if they were its, on any CPU,
+//          a new process at the same address must not look like their owner
+void fpu_free(pcb_t* pcb){
+    uint32_t i;
+
+    for(i = 0; i < nr_cpus; i++){
+        if(cpus[i].fpu_owner == pcb){
+            cpus[i].fpu_owner = NULL;
+        }
+    }
+    if(pcb->fpu_state != NULL){
+        kmem_cache_free(fpu_cache, pcb->fpu_state);
+        pcb->fpu_state = NULL;
+    }
+}
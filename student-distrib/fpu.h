@@ -0,0 +1,42 @@
+// lazy FPU and SSE state switching header file
+#ifndef _FPU_H
+#define _FPU_H
+
+#include "types.h"
+
+// bytes fxsave writes, fnsave only needs 108
+#define FPU_STATE_SIZE 512
+
+#define CR0_MP 0x00000002 // wait and friends trap on TS too
+#define CR0_EM 0x00000004 // no FPU, every FPU instruction traps
+#define CR0_TS 0x00000008 // task switched, the next FPU instruction raises #NM
+#define CR0_NE 0x00000020 // report x87 errors as exception 16
+#define CR4_OSFXSR     0x00000200 // we save state with fxsave, enables SSE
+#define CR4_OSXMMEXCPT 0x00000400 // report SSE errors as exception 19
+
+// CPUID leaf 1 EDX feature bits
+#define CPUID_FXSR 0x01000000
+#define CPUID_SSE  0x02000000
+
+struct pcb_t;
+
+// turns on the FPU and SSE, must run after kmem_init
+extern void fpu_init(void);
+
+// turns on the FPU of a CPU started after the boot CPU
+extern void fpu_cpu_init(void);
+
+// called by schedule before switching from prev to next, the next FPU
+// instruction traps unless next still owns this CPU's FPU registers
+extern void fpu_switch(struct pcb_t* prev, struct pcb_t* next);
+
+// handles vector 7, called from nm_wrapper
+extern void fpu_nm_handler(void);
+
+// gives a forked child a copy of the parent's FPU state, returns 0 or -1
+extern int32_t fpu_fork(struct pcb_t* child, struct pcb_t* parent);
+
+// frees the FPU state of a process
+extern void fpu_free(struct pcb_t* pcb);
+
+#endif /* _FPU_H */
@@ -4,6 +4,8 @@
 
 #include "i8259.h"
 #include "lib.h"
+#include "ioapic.h"
+#include "lapic.h"
 
 #define PIC1 0x20
 #define PIC2 0xA0
@@ -77,6 +79,12 @@ void enable_irq(uint32_t irq_num) {
     uint16_t port; // The I/O port to which the command will be sent.
     uint8_t value; // The value to be sent to the port.
 
+    // once the I/O APIC has the interrupts the 8259 stays masked
+    if(ioapic_active) {
+        ioapic_enable_irq(irq_num);
+        return;
+    }
+
     // If the IRQ number is less than 8, it means that the interrupt was sent by the master PIC.
     if(irq_num < MASTER_IRQS) {
         port = PIC1_DATA; // Master PIC's data port
@@ -99,6 +107,11 @@ void disable_irq(uint32_t irq_num) {
     uint16_t port; // The I/O port to which the command will be sent.
     uint8_t value; // The value to be sent to the port.
 
+    if(ioapic_active) {
+        ioapic_disable_irq(irq_num);
+        return;
+    }
+
     // If the IRQ number is less than 8, it means that the interrupt was sent by the master PIC.
     if(irq_num < MASTER_IRQS) {
         port = PIC1_DATA; // Master PIC's data port
@@ -120,6 +133,11 @@ void disable_irq(uint32_t irq_num) {
 // Outputs: none
 // Effects: Sends an EOI signal to the specified IRQ line.
 void send_eoi(uint32_t irq_num) {
+    // interrupts from the I/O APIC are acknowledged with one MMIO write
+    if(ioapic_active) {
+        lapic_eoi();
+        return;
+    }
     // If the IRQ number is 8 or more, it means that the interrupt was sent by the slave PIC.
     // The slave PIC is connected to the master PIC's IRQ2 line.
     if(irq_num >= MASTER_IRQS){
@@ -135,3 +153,16 @@ void send_eoi(uint32_t irq_num) {
         outb(EOI | irq_num, PIC1_COMMAND);
     }
 }
+
+// This function is used to hand the interrupts over to the I/O APIC.
+// Inputs: none
+// Outputs: the mask both PICs had, IRQs 8-15 in the high byte
+// Effects: Masks every IRQ line on both PICs.
+uint16_t i8259_mask_all(void) {
+    uint16_t mask = inb(PIC1_DATA) | (inb(PIC2_DATA) << MASTER_IRQS);
+
+    master_mask = slave_mask = 0xFF;
+    outb(master_mask, PIC1_DATA);
+    outb(slave_mask, PIC2_DATA);
+    return mask;
+}
@@ -42,5 +42,7 @@ void enable_irq(uint32_t irq_num);
 void disable_irq(uint32_t irq_num);
 /* Send end-of-interrupt signal for the specified IRQ */
 void send_eoi(uint32_t irq_num);
+/* Mask every IRQ for good, returns the old mask */
+uint16_t i8259_mask_all(void);
 
 #endif /* _I8259_H */
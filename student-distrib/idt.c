@@ -1,5 +1,6 @@
 #include "idt.h"
 #include "idt_wrapper.h"
+#include "lapic.h"
 
 
 #define SYS_CALL 0x80
@@ -39,10 +40,6 @@ void exception_6 () {
     exception_wrapper(6);
 }
 
-void exception_7 () {
-    exception_wrapper(7);
-}
-
 void exception_8 () {
     exception_wrapper(8);
 }
@@ -68,10 +65,6 @@ void exception_13 () {
     exception_wrapper(13);
 }
 
-void exception_14 () {
-    exception_wrapper(14);
-}
-
 void exception_15 () {
     exception_wrapper(15);
 }
@@ -137,14 +130,14 @@ void init_idt() {
     SET_IDT_ENTRY(idt[4], exception_4);
     SET_IDT_ENTRY(idt[5], exception_5);
     SET_IDT_ENTRY(idt[6], exception_6);
-    SET_IDT_ENTRY(idt[7], exception_7);
+    SET_IDT_ENTRY(idt[7], nm_wrapper);
     SET_IDT_ENTRY(idt[8], exception_8);
     SET_IDT_ENTRY(idt[9], exception_9);
     SET_IDT_ENTRY(idt[10], exception_10);
     SET_IDT_ENTRY(idt[11], exception_11);
     SET_IDT_ENTRY(idt[12], exception_12);
     SET_IDT_ENTRY(idt[13], exception_13);
-    SET_IDT_ENTRY(idt[14], exception_14);
+    SET_IDT_ENTRY(idt[14], page_fault_wrapper);
     SET_IDT_ENTRY(idt[15], exception_15);
     SET_IDT_ENTRY(idt[16], exception_16);
     SET_IDT_ENTRY(idt[17], exception_17);
@@ -158,12 +151,31 @@ void init_idt() {
     SET_IDT_ENTRY(idt[KEYBOARD], kb_wrapper);
     SET_IDT_ENTRY(idt[RTC], rtc_wrapper);
     SET_IDT_ENTRY(idt[PIT], pit_wrapper);
+    SET_IDT_ENTRY(idt[LAPIC_TIMER_VECTOR], lapic_timer_wrapper);
+    SET_IDT_ENTRY(idt[IPI_RESCHED_VECTOR], ipi_resched_wrapper);
+    SET_IDT_ENTRY(idt[IPI_TICK_VECTOR], ipi_tick_wrapper);
+    SET_IDT_ENTRY(idt[IPI_TLB_VECTOR], ipi_tlb_wrapper);
+    SET_IDT_ENTRY(idt[LAPIC_SPURIOUS_VECTOR], spurious_wrapper);
     lidt(idt_desc_ptr);
     return;
 }
 
 
 
+// Page fault handler
+// Inputs: error_code - pushed by the processor for the fault
+// Outputs: none
+// Effects: demand-zero and copy-on-write faults are fixed up and retried, anything else squashes the program
+void page_fault_handler(uint32_t error_code) {
+    uint32_t addr;
+    asm volatile("movl %%cr2, %0" : "=r" (addr));
+
+    if(user_page_fault(addr, error_code) == 0) {
+        return;
+    }
+    exception_handler(14);
+}
+
 // Common exception handler
 // Inputs: exception vector id
 // Outputs: none
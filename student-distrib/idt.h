@@ -16,4 +16,7 @@ void init_idt();
 
 extern void exception_handler(uint32_t exception_id);
 
+// handles vector 14, called from page_fault_wrapper
+extern void page_fault_handler(uint32_t error_code);
+
 #endif /* _IDT_H */
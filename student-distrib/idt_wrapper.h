@@ -12,6 +12,19 @@ extern void rtc_wrapper();
 // wrapper function for pit_irq_handler
 extern void pit_wrapper();
 
+// wrappers for the local APIC vectors
+extern void lapic_timer_wrapper();
+extern void ipi_resched_wrapper();
+extern void ipi_tick_wrapper();
+extern void ipi_tlb_wrapper();
+extern void spurious_wrapper();
+
+// wrapper function for fpu_nm_handler
+extern void nm_wrapper();
+
+// wrapper function for page_fault_handler
+extern void page_fault_wrapper();
+
 // common assembly wrapper for exceptions raised
 extern void exception_wrapper(uint32_t exception_id);
 
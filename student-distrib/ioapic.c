@@ -0,0 +1,171 @@
+// I/O APIC
+// takes the device interrupts over from the 8259 when the MP table says
+// where it is, every ISA IRQ keeps its vector and goes to the boot CPU,
+// which acknowledges it with a write to its local APIC instead of port I/O
+
+#include "ioapic.h"
+#include "i8259.h"
+#include "lib.h"
+#include "paging.h"
+#include "spinlock.h"
+
+uint32_t ioapic_active;
+
+// pin each ISA IRQ is wired to, and the polarity and trigger mode bits it needs
+static uint32_t irq_pin[ISA_IRQS];
+static uint32_t irq_mode[ISA_IRQS];
+// highest pin the I/O APIC has
+static uint32_t max_pin;
+// the index and the data window are one pair for every CPU
+static spinlock_t ioapic_lock = SPINLOCK_INIT;
+
+// Description: reads an I/O APIC register
+// Inputs: reg - register index
+// Outputs: its value
+// Effects: ioapic_lock must be held
+static uint32_t ioapic_read(uint32_t reg){
+    *(volatile uint32_t*)(IOAPIC_VIRT + IOAPIC_REGSEL) = reg;
+    return *(volatile uint32_t*)(IOAPIC_VIRT + IOAPIC_WIN);
+}
+
+// Description: writes an I/O APIC register
+// Inputs: reg - register index, val - value to write
+// Outputs: none
+// Effects: ioapic_lock must be held
+static void ioapic_write(uint32_t reg, uint32_t val){
+    *(volatile uint32_t*)(IOAPIC_VIRT + IOAPIC_REGSEL) = reg;
+    *(volatile uint32_t*)(IOAPIC_VIRT + IOAPIC_WIN) = val;
+}
+
+// Description: maps the I/O APIC registers at IOAPIC_VIRT
+// Inputs: phys - physical address of the registers
+// Outputs: none
+// Effects: uncached and global, like the local APIC
+static void ioapic_map(uint32_t phys){
+    page_table_entry_t pte = page_table[IOAPIC_VIRT >> SHIFT_12];
+
+    pte.present = pte.rw = 1;
+    pte.us = 0;
+    pte.pcd = pte.pwt = 1;
+    pte.g = 1;
+    pte.addy = phys >> SHIFT_12;
+    set_pte(page_table, IOAPIC_VIRT, pte);
+}
+
+// Description: turns the flags of an MP interrupt entry into redirection entry bits
+// Inputs: flags - polarity and trigger mode from the MP table
+// Outputs: the bits, ISA interrupts are active high and edge triggered unless it says otherwise
+static uint32_t mp_int_mode(uint16_t flags){
+    uint32_t mode = 0;
+
+    if((flags & MP_POLARITY_MASK) == MP_POLARITY_LOW){
+        mode |= IOAPIC_INT_ACTIVELOW;
+    }
+    if(((flags >> MP_TRIGGER_SHIFT) & MP_TRIGGER_MASK) == MP_TRIGGER_LEVEL){
+        mode |= IOAPIC_INT_LEVEL;
+    }
+    return mode;
+}
+
+// Description: finds the I/O APIC and moves the device interrupts to it
+// Inputs: config - the MP configuration table, it must be mapped
+// Outputs: 0, or -1 if there is no I/O APIC
+// Effects: the IRQs the 8259 had enabled stay enabled, the 8259 is masked for good
+//          and cpus[0].apic_id must be set
+int32_t ioapic_init(mp_config_t* config){
+    mp_ioapic_t* ioapic = NULL;
+    mp_ioint_t* ioint;
+    mp_bus_t* bus;
+    int32_t isa_bus = -1;
+    uint32_t entry, i;
+    uint16_t pic_mask;
+
+    // without an override each ISA IRQ is wired to the pin of the same number
+    for(i = 0; i < ISA_IRQS; i++){
+        irq_pin[i] = i;
+        irq_mode[i] = 0;
+    }
+
+    // the spec lists buses before I/O APICs and those before the interrupts
+    entry = (uint32_t)config + sizeof(mp_config_t);
+    for(i = 0; i < config->entry_count; i++){
+        switch(*(uint8_t*)entry){
+            case MP_ENTRY_PROCESSOR:
+                entry += MP_PROCESSOR_SIZE;
+                continue;
+            case MP_ENTRY_BUS:
+                bus = (mp_bus_t*)entry;
+                if(strncmp(bus->bus_type, MP_BUS_ISA, MP_BUS_TYPE_LEN) == 0){
+                    isa_bus = bus->bus_id;
+                }
+                break;
+            case MP_ENTRY_IOAPIC:
+                // a second I/O APIC would only have PCI interrupts
+                if(ioapic == NULL && (((mp_ioapic_t*)entry)->flags & MP_IOAPIC_ENABLED)){
+                    ioapic = (mp_ioapic_t*)entry;
+                }
+                break;
+            case MP_ENTRY_IOINT:
+                ioint = (mp_ioint_t*)entry;
+                if(ioapic != NULL && ioint->int_type == MP_INT_TYPE_INT && ioint->src_bus == isa_bus &&
+                   ioint->src_irq < ISA_IRQS &&
+                   (ioint->dst_apic == ioapic->apic_id || ioint->dst_apic == MP_ALL_IOAPICS)){
+                    irq_pin[ioint->src_irq] = ioint->dst_pin;
+                    irq_mode[ioint->src_irq] = mp_int_mode(ioint->flags);
+                }
+                break;
+        }
+        entry += MP_OTHER_SIZE;
+    }
+    if(ioapic == NULL){
+        return -1;
+    }
+
+    ioapic_map(ioapic->addr);
+    spin_lock(&ioapic_lock);
+    max_pin = (ioapic_read(IOAPIC_VER) >> IOAPIC_MAX_REDIR_SHIFT) & IOAPIC_MAX_REDIR_MASK;
+    for(i = 0; i <= max_pin; i++){
+        ioapic_write(IOAPIC_REDTBL + 2 * i, IOAPIC_INT_MASKED);
+        ioapic_write(IOAPIC_REDTBL + 2 * i + 1, 0);
+    }
+    spin_unlock(&ioapic_lock);
+
+    pic_mask = i8259_mask_all();
+    ioapic_active = 1;
+    for(i = 0; i < ISA_IRQS; i++){
+        if(i != ISA_CASCADE_IRQ && !(pic_mask & (1 << i))){
+            ioapic_enable_irq(i);
+        }
+    }
+    return 0;
+}
+
+// Description: unmasks an ISA IRQ
+// Inputs: irq - IRQ number as the 8259 knows it
+// Outputs: none
+// Effects: it is delivered to the boot CPU on vector ISA_IRQ_VECTOR + irq
+void ioapic_enable_irq(uint32_t irq){
+    uint32_t flags;
+
+    if(irq >= ISA_IRQS || irq_pin[irq] > max_pin){
+        return;
+    }
+    spin_lock_irqsave(&ioapic_lock, flags);
+    ioapic_write(IOAPIC_REDTBL + 2 * irq_pin[irq] + 1, cpus[0].apic_id << IOAPIC_DEST_SHIFT);
+    ioapic_write(IOAPIC_REDTBL + 2 * irq_pin[irq], (ISA_IRQ_VECTOR + irq) | irq_mode[irq]);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
+
+// Description: masks an ISA IRQ
+// Inputs: irq - IRQ number as the 8259 knows it
+// Outputs: none
+void ioapic_disable_irq(uint32_t irq){
+    uint32_t flags;
+
+    if(irq >= ISA_IRQS || irq_pin[irq] > max_pin){
+        return;
+    }
+    spin_lock_irqsave(&ioapic_lock, flags);
+    ioapic_write(IOAPIC_REDTBL + 2 * irq_pin[irq], (ISA_IRQ_VECTOR + irq) | irq_mode[irq] | IOAPIC_INT_MASKED);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
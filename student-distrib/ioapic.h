@@ -0,0 +1,81 @@
+// I/O APIC header file
+#ifndef _IOAPIC_H
+#define _IOAPIC_H
+
+#include "types.h"
+#include "smp.h"
+
+// where the registers show up, the page below the local APIC's
+#define IOAPIC_VIRT         0x3FE000
+
+// the registers are reached through an index and a data window
+#define IOAPIC_REGSEL       0x00
+#define IOAPIC_WIN          0x10
+// register indices
+#define IOAPIC_VER          0x01
+#define IOAPIC_REDTBL       0x10
+#define IOAPIC_MAX_REDIR_SHIFT 16
+#define IOAPIC_MAX_REDIR_MASK  0xFF
+
+// redirection entry bits, the low word also holds the vector
+#define IOAPIC_INT_ACTIVELOW    0x00002000
+#define IOAPIC_INT_LEVEL        0x00008000
+#define IOAPIC_INT_MASKED       0x00010000
+#define IOAPIC_DEST_SHIFT       24
+
+// MP table entries about I/O APICs and how the interrupts are wired to them
+#define MP_ENTRY_BUS        1
+#define MP_ENTRY_IOAPIC     2
+#define MP_ENTRY_IOINT      3
+#define MP_IOAPIC_ENABLED   0x01
+#define MP_INT_TYPE_INT     0
+#define MP_ALL_IOAPICS      0xFF
+#define MP_POLARITY_MASK    0x3
+#define MP_POLARITY_LOW     0x3
+#define MP_TRIGGER_SHIFT    2
+#define MP_TRIGGER_MASK     0x3
+#define MP_TRIGGER_LEVEL    0x3
+#define MP_BUS_ISA          "ISA   "
+#define MP_BUS_TYPE_LEN     6
+
+// ISA IRQs keep the vectors the 8259 gave them
+#define ISA_IRQ_VECTOR      0x20
+#define ISA_IRQS            16
+#define ISA_CASCADE_IRQ     2
+
+typedef struct __attribute__((packed)) mp_bus_t {
+    uint8_t type;
+    uint8_t bus_id;
+    int8_t bus_type[MP_BUS_TYPE_LEN];
+} mp_bus_t;
+
+typedef struct __attribute__((packed)) mp_ioapic_t {
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t version;
+    uint8_t flags;
+    uint32_t addr;
+} mp_ioapic_t;
+
+typedef struct __attribute__((packed)) mp_ioint_t {
+    uint8_t type;
+    uint8_t int_type;
+    uint16_t flags;
+    uint8_t src_bus;
+    uint8_t src_irq;
+    uint8_t dst_apic;
+    uint8_t dst_pin;
+} mp_ioint_t;
+
+// set once the I/O APIC has taken over from the 8259
+extern uint32_t ioapic_active;
+
+// finds the I/O APIC in the MP table and moves every device interrupt to it,
+// returns 0 or -1 if there is none and the 8259 stays in charge
+extern int32_t ioapic_init(mp_config_t* config);
+
+// unmask and mask an ISA IRQ, it is delivered to the boot CPU
+extern void ioapic_enable_irq(uint32_t irq);
+extern void ioapic_disable_irq(uint32_t irq);
+
+#endif /* _IOAPIC_H */
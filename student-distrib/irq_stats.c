@@ -0,0 +1,34 @@
+// interrupts-off time of every interrupt handler
+// handlers read the TSC on entry and report here before they return
+
+#include "irq_stats.h"
+#include "lib.h"
+#include "spinlock.h"
+
+irq_stats_t irq_stats[NUM_IRQS];
+
+// Description: timestamps the start of an interrupt handler
+// Inputs: none
+// Outputs: low 32 bits of the TSC
+// Effects: none
+uint32_t irq_stats_enter(void){
+    return (uint32_t)rdtsc();
+}
+
+// Description: records how long a handler kept interrupts off
+// Inputs: irq - interrupt line of the handler
+//         start - value returned by irq_stats_enter
+// Outputs: none
+// Effects: adds a sample to the line's histogram
+void irq_stats_exit(uint32_t irq, uint32_t start){
+    // handlers are much shorter than a 32-bit wrap of the TSC
+    uint32_t cycles = (uint32_t)rdtsc() - start;
+
+    if(irq >= NUM_IRQS){
+        return;
+    }
+    // handlers on other CPUs update the same line
+    atomic_inc(&irq_stats[irq].count);
+    atomic_max(&irq_stats[irq].max_cycles, cycles);
+    atomic_inc(&irq_stats[irq].hist[syscall_stats_bucket(cycles)]);
+}
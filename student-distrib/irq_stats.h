@@ -0,0 +1,28 @@
+// interrupt handler statistics header file
+#ifndef _IRQ_STATS_H
+#define _IRQ_STATS_H
+
+#include "types.h"
+#include "syscall_stats.h"
+
+// lines of the two PICs
+#define NUM_IRQS 16
+
+// how long each interrupt line keeps interrupts off
+// the handlers run with interrupts disabled from entry until irq_stats_exit,
+// bucket i of hist counts handlers that took [2^i, 2^(i+1)) TSC cycles
+typedef struct irq_stats_t {
+    uint32_t count;
+    uint32_t max_cycles;
+    uint32_t hist[SYSSTAT_BUCKETS];
+} irq_stats_t;
+
+extern irq_stats_t irq_stats[NUM_IRQS];
+
+// called first thing in a handler, returns the low half of the TSC
+extern uint32_t irq_stats_enter(void);
+
+// called once the handler is done with the work it does with interrupts off
+extern void irq_stats_exit(uint32_t irq, uint32_t start);
+
+#endif /* _IRQ_STATS_H */
@@ -89,12 +89,12 @@ void keyboard_init(void){
 
 // handles interrupt for keyboard
 // interacts with linkage/wrapper function
+// only reads the scancode, keyboard_process does the rest with interrupts on
 // Inputs: none
 // Outputs: none
-// Effects: prints keyboard input to screen
+// Effects: queues the scancode for the bottom half worker
 void keyboard_irq_handler(void){
-    // stop interrupts for other things while handling keyboard
-    cli();
+    uint32_t start = irq_stats_enter();
 
     // send end of interrupt to PIC
     send_eoi(KEYBOARD_IRQ);
@@ -102,6 +102,27 @@ void keyboard_irq_handler(void){
     // retrieve scancode from keyboard input
     uint8_t scancode = inb(KEYBOARD_PORT_DATA);  
 
+#if KEYBOARD_BOTTOM_HALF
+    // a full queue drops the key
+    int32_t queued = bh_queue(keyboard_process, scancode);
+    irq_stats_exit(KEYBOARD_IRQ, start);
+    // let the worker echo the key right away
+    if(queued == 0){
+        schedule();
+    }
+#else
+    keyboard_process(scancode);
+    irq_stats_exit(KEYBOARD_IRQ, start);
+#endif
+}
+
+// handles one scancode
+// Inputs: scancode - scancode read by keyboard_irq_handler
+// Outputs: none
+// Effects: prints keyboard input to screen, switches terminals, ctrl + c kills
+//          the foreground program of the terminal on screen
+void keyboard_process(uint32_t scancode){
+
     // convert scancode into ascii value
     // if a special key is pressed
     // we must handle it accordingly
@@ -110,39 +131,30 @@ void keyboard_irq_handler(void){
     switch(scancode){
         case CAPS:
             caps_flag = (~caps_flag) & 0x1;
-            sti();
             return;
         case LSHIFT:
             shift_flag = 1;
-            sti();
             return;
         case RSHIFT:
             shift_flag = 1;
-            sti();
             return;
         case LSHIFT_RELEASE:
             shift_flag = 0;
-            sti();
             return;
         case RSHIFT_RELEASE:
             shift_flag = 0;
-            sti();
             return;
         case CTRL:
             ctrl_flag = 1;
-            sti();
             return;
         case CTRL_RELEASE:
             ctrl_flag = 0;
-            sti();
             return;
         case ALT:
             alt_flag = 1;
-            sti();
             return;
         case ALT_RELEASE:
             alt_flag = 0;
-            sti();
             return;
         default:
             // set pressed value to proper ascii
@@ -182,13 +194,14 @@ void keyboard_irq_handler(void){
     } else if (ctrl_flag && ((pressed == 'l') || (pressed == 'L'))){
         clear_screen();
     } else if (ctrl_flag && ((pressed == 'c') || (pressed == 'C'))){
-        halt(USER_HALT);
+        process_kill(terminal_array[current_terminal].fg_pid);
     } else if(pressed == '\n' || pressed == '\r'){
         if(count[current_terminal] < BUF_SIZE){
             putc(pressed);
             kb_buffer[current_terminal][count[current_terminal]] = pressed;
             count[current_terminal]++;
-            read_flag = 1;
+            read_flag[current_terminal] = 1;
+            wq_wake_all(&terminal_array[current_terminal].read_wq);
         }
     } else if(alt_flag && (scancode == F1_CODE)){
         open_terminal(0);
@@ -205,8 +218,6 @@ void keyboard_irq_handler(void){
             count[current_terminal]++;
         }
     }
-    // allow interrupts now
-    sti();
     return;
 }
 
@@ -7,8 +7,12 @@
 #include "terminal.h"
 #include "systemcall.h"
 #include "lib.h"
+#include "bottom_half.h"
+#include "irq_stats.h"
 
 #define KEYBOARD_IRQ   1
+// set to 0 to handle keys inside the interrupt handler, for comparing irqstat numbers
+#define KEYBOARD_BOTTOM_HALF 1
 #define TERMINAL_COUNT 3
 
 //keyboard ports
@@ -38,10 +42,10 @@
 #define TAB_SIZE 5
 #define USER_HALT 42
 
-uint8_t caps_flag;
-uint8_t shift_flag;
-uint8_t ctrl_flag;
-uint8_t alt_flag;
+extern uint8_t caps_flag;
+extern uint8_t shift_flag;
+extern uint8_t ctrl_flag;
+extern uint8_t alt_flag;
 
 // keyboard buffer, should allow only 127 characters to be shown on screen, 128th character saved for ENTER
 // count variable used to count current index in the array
@@ -57,6 +61,9 @@ extern void keyboard_init(void);
 // used in wrapper/linkage function
 extern void keyboard_irq_handler(void);
 
+// handles one scancode, runs as a bottom half
+extern void keyboard_process(uint32_t scancode);
+
 // sets all values in buffer to 0
 // resets count to 0
 extern void clear_buffer();
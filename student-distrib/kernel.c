@@ -15,6 +15,12 @@
 #include "file_sys.h"
 #include "systemcall.h"
 #include "schedule.h"
+#include "buddy.h"
+#include "slab.h"
+#include "fpu.h"
+#include "bottom_half.h"
+#include "smp.h"
+#include "clock.h"
 
 #define RUN_TESTS
 
@@ -154,10 +160,20 @@ void entry(unsigned long magic, unsigned long addr) {
     init_idt();
     rtc_init();
     keyboard_init();
+    buddy_init(mbi);
     page_init();
+    kmem_init();
+    fpu_init();
+    init_process_caches();
+    sched_init();
+    bh_init();
     init_fops_tables();
     term_init();
-    PIT_init();
+    /* Measure the TSC while nothing can interrupt us */
+    clock_init();
+    /* Start the other CPUs, they wait in their idle task for work */
+    smp_init();
+    tick_init();
 
     /* Do not enable the following until after you have set up your
      * IDT correctly otherwise QEMU will triple fault and simple close
@@ -170,8 +186,8 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Run tests */
     launch_tests();
 #endif
-    /* Execute the first program ("shell") ... */
-    execute( (uint8_t*)"shell" );
-    /* Spin (nicely, so we don't chew up cycles) */
-    asm volatile (".1: hlt; jmp .1;");
+    /* Start the first program ("shell"), the scheduler runs it on the next tick */
+    start_shell(0);
+    /* This is now the idle task, spin (nicely, so we don't chew up cycles) */
+    cpu_idle();
 }
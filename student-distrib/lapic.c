@@ -0,0 +1,141 @@
+// local APIC
+// every CPU has one, it takes interrupts from the other CPUs and is how
+// the boot CPU starts them in the first place
+
+#include "lapic.h"
+#include "ioapic.h"
+#include "clock.h"
+#include "lib.h"
+#include "paging.h"
+
+uint32_t lapic_timer_count;
+
+// Description: reads a local APIC register
+// Inputs: reg - register offset
+// Outputs: its value
+static uint32_t lapic_read(uint32_t reg){
+    return *(volatile uint32_t*)(LAPIC_VIRT + reg);
+}
+
+// Description: writes a local APIC register
+// Inputs: reg - register offset, val - value to write
+// Outputs: none
+static void lapic_write(uint32_t reg, uint32_t val){
+    *(volatile uint32_t*)(LAPIC_VIRT + reg) = val;
+}
+
+// Description: maps the local APIC registers at LAPIC_VIRT
+// Inputs: phys - physical address of the registers
+// Outputs: none
+// Effects: uncached and global, the mapping is the same on every CPU
+void lapic_map(uint32_t phys){
+    page_table_entry_t pte = page_table[LAPIC_VIRT >> SHIFT_12];
+
+    pte.present = pte.rw = 1;
+    pte.us = 0;
+    pte.pcd = pte.pwt = 1;
+    pte.g = 1;
+    pte.addy = phys >> SHIFT_12;
+    set_pte(page_table, LAPIC_VIRT, pte);
+}
+
+// Description: turns on the local APIC of the calling CPU
+// Inputs: bsp - nonzero on the boot CPU
+// Outputs: none
+// Effects: the boot CPU keeps the PIC wired through LINT0, unless the I/O APIC
+//          took over, and NMIs through LINT1, on the others both are masked so
+//          every device interrupt goes to one place
+void lapic_init(uint32_t bsp){
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT0, (bsp && !ioapic_active) ? LAPIC_DM_EXTINT : LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, bsp ? LAPIC_DM_NMI : LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    // the error status register is cleared by writing it, twice to be sure
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_eoi();
+}
+
+// Description: finds out which CPU we are on
+// Inputs: none
+// Outputs: APIC id of the calling CPU
+uint32_t lapic_id(void){
+    return lapic_read(LAPIC_ID) >> LAPIC_ID_SHIFT;
+}
+
+// Description: acknowledges the interrupt being handled
+// Inputs: none
+// Outputs: none
+// Effects: not for the spurious vector or interrupts from the PIC
+void lapic_eoi(void){
+    lapic_write(LAPIC_EOI, 0);
+}
+
+// Description: waits until the last interprocessor interrupt was sent
+// Inputs: none
+// Outputs: none
+static void lapic_wait_icr(void){
+    while(lapic_read(LAPIC_ICR_LO) & LAPIC_ICR_PENDING){
+        asm volatile("pause");
+    }
+}
+
+// Description: sends an interprocessor interrupt to one CPU
+// Inputs: apic_id - APIC id of the target
+//         icr - delivery mode, level and vector
+// Outputs: none
+// Effects: returns once the local APIC has sent it
+void lapic_send_ipi(uint32_t apic_id, uint32_t icr){
+    uint32_t flags;
+
+    // an interrupt handler sending one of its own must not get between the two writes
+    cli_and_save(flags);
+    lapic_write(LAPIC_ICR_HI, apic_id << LAPIC_ID_SHIFT);
+    lapic_write(LAPIC_ICR_LO, icr);
+    lapic_wait_icr();
+    restore_flags(flags);
+}
+
+// Description: sends an interprocessor interrupt to every other CPU
+// Inputs: icr - delivery mode, level and vector
+// Outputs: none
+// Effects: returns once the local APIC has sent it
+void lapic_broadcast_ipi(uint32_t icr){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    lapic_write(LAPIC_ICR_HI, 0);
+    lapic_write(LAPIC_ICR_LO, icr | LAPIC_DEST_OTHERS);
+    lapic_wait_icr();
+    restore_flags(flags);
+}
+
+// Description: measures how fast the timer counts
+// Inputs: pit_count - PIT clocks in one scheduler tick
+// Outputs: none
+// Effects: sets lapic_timer_count, busy waits one tick on PIT channel 2,
+//          which channel 0 and its interrupt are not involved in
+void lapic_timer_calibrate(uint32_t pit_count){
+    uint32_t left;
+
+    lapic_write(LAPIC_TIMER_DCR, LAPIC_TIMER_DIV16);
+    pit_ch2_start(pit_count);
+    lapic_write(LAPIC_TIMER_ICR, LAPIC_TIMER_MAX);
+    pit_ch2_wait();
+    left = lapic_read(LAPIC_TIMER_CCR);
+
+    lapic_write(LAPIC_TIMER_ICR, 0);
+    lapic_timer_count = LAPIC_TIMER_MAX - left;
+}
+
+// Description: starts the timer of the calling CPU
+// Inputs: none
+// Outputs: none
+// Effects: LAPIC_TIMER_VECTOR fires every lapic_timer_count counts from now on
+void lapic_timer_start(void){
+    lapic_write(LAPIC_TIMER_DCR, LAPIC_TIMER_DIV16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_ICR, lapic_timer_count);
+}
@@ -0,0 +1,84 @@
+// local APIC header file
+#ifndef _LAPIC_H
+#define _LAPIC_H
+
+#include "types.h"
+
+// where the registers show up, the last page of the first 4MB so the
+// mapping sits in page_table and every page directory shares it
+#define LAPIC_VIRT          0x3FF000
+// where the registers are if the MP table does not say otherwise
+#define LAPIC_DEFAULT_PHYS  0xFEE00000
+
+// register offsets
+#define LAPIC_ID        0x020
+#define LAPIC_TPR       0x080
+#define LAPIC_EOI       0x0B0
+#define LAPIC_SVR       0x0F0
+#define LAPIC_ESR       0x280
+#define LAPIC_ICR_LO    0x300
+#define LAPIC_ICR_HI    0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+#define LAPIC_LVT_ERROR 0x370
+#define LAPIC_TIMER_ICR 0x380
+#define LAPIC_TIMER_CCR 0x390
+#define LAPIC_TIMER_DCR 0x3E0
+
+#define LAPIC_ID_SHIFT      24
+#define LAPIC_SVR_ENABLE    0x00000100
+#define LAPIC_LVT_MASKED    0x00010000
+#define LAPIC_TIMER_PERIODIC 0x00020000
+// the timer counts the bus clock divided by 16
+#define LAPIC_TIMER_DIV16   0x3
+#define LAPIC_TIMER_MAX     0xFFFFFFFF
+
+// delivery modes of the LVT entries and the ICR
+#define LAPIC_DM_FIXED      0x00000000
+#define LAPIC_DM_NMI        0x00000400
+#define LAPIC_DM_INIT       0x00000500
+#define LAPIC_DM_STARTUP    0x00000600
+#define LAPIC_DM_EXTINT     0x00000700
+// more ICR bits
+#define LAPIC_ICR_PENDING   0x00001000
+#define LAPIC_ICR_ASSERT    0x00004000
+#define LAPIC_ICR_LEVEL     0x00008000
+#define LAPIC_DEST_OTHERS   0x000C0000
+
+// interrupt vectors of the local APIC, above everything the PIC uses
+#define LAPIC_TIMER_VECTOR      0xF0
+#define IPI_RESCHED_VECTOR      0xF1
+#define IPI_TICK_VECTOR         0xF2
+#define IPI_TLB_VECTOR          0xF3
+#define LAPIC_SPURIOUS_VECTOR   0xFF
+
+// maps the registers, must run before anything else here
+extern void lapic_map(uint32_t phys);
+
+// turns on the local APIC of the calling CPU
+// the boot CPU keeps getting PIC interrupts through LINT0, the others do not
+extern void lapic_init(uint32_t bsp);
+
+// APIC id of the calling CPU
+extern uint32_t lapic_id(void);
+
+// acknowledges an interrupt the local APIC delivered
+extern void lapic_eoi(void);
+
+// sends an interprocessor interrupt to one CPU and waits until it is accepted
+extern void lapic_send_ipi(uint32_t apic_id, uint32_t icr);
+
+// sends an interprocessor interrupt to every CPU but this one
+extern void lapic_broadcast_ipi(uint32_t icr);
+
+// timer counts per scheduler tick, 0 until lapic_timer_calibrate found it
+extern uint32_t lapic_timer_count;
+
+// measures the timer against pit_count clocks of the PIT, which must be one tick
+extern void lapic_timer_calibrate(uint32_t pit_count);
+
+// starts the calling CPU's timer, one interrupt per scheduler tick
+extern void lapic_timer_start(void);
+
+#endif /* _LAPIC_H */
@@ -6,6 +6,7 @@
 int screen_x[TERMINAL_COUNT] = {0,0,0};
 int screen_y[TERMINAL_COUNT] = {0,0,0};
 static char* video_mem = (char *)VIDEO;
+spinlock_t console_lock = SPINLOCK_INIT;
 
 static int line_tracker[NUM_ROWS] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0 ,  0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0};
 
@@ -160,11 +161,11 @@ int32_t puts(int8_t* s) {
     return index;
 }
 
-/* void putc(uint8_t c);
+/* static void putc_locked(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
- *  Function: Output a character to the console */
-void putc(uint8_t c) {
+ *  Function: Output a character to the console, console_lock must be held */
+static void putc_locked(uint8_t c) {
     // don't print anything if its not a valid char
     if(c == 0 || c == '\0'){
         return;
@@ -176,7 +177,7 @@ void putc(uint8_t c) {
     } else if (c == '\t'){
         int i;
         for (i = 0; i < TAB_SIZE; i++){
-            putc(' ');
+            putc_locked(' ');
         }
     } else {
         *(uint8_t *)(video_mem + ((NUM_COLS * screen_y[current_terminal] + screen_x[current_terminal]) << 1)) = c;
@@ -196,11 +197,24 @@ void putc(uint8_t c) {
     return;
 }
 
+/* void putc(uint8_t c);
+ * Inputs: uint_8* c = character to print
+ * Return Value: void
+ *  Function: Output a character to the console */
+void putc(uint8_t c) {
+    uint32_t flags;
+    spin_lock_irqsave(&console_lock, flags);
+    putc_locked(c);
+    spin_unlock_irqrestore(&console_lock, flags);
+}
+
 /* void del_c();
  * Inputs: None
  * Return Value: void
  *  Function: Deletes the latest character from screen */
 void del_c() {
+    uint32_t flags;
+    spin_lock_irqsave(&console_lock, flags);
     if(screen_x[current_terminal] == 0) {
         if(screen_y[current_terminal] > 0){
             screen_y[current_terminal]--;
@@ -215,6 +229,7 @@ void del_c() {
         *(uint8_t *)(video_mem + ((NUM_COLS * screen_y[current_terminal] + screen_x[current_terminal]) << 1) + 1) = ATTRIB;
         update_cursor(screen_x[current_terminal], screen_y[current_terminal]);
     }
+    spin_unlock_irqrestore(&console_lock, flags);
     return;
 }
 
@@ -223,10 +238,13 @@ void del_c() {
  * Return Value: void
  *  Function: Clears entire screen and resets cursor to top left */
 void clear_screen() {
+    uint32_t flags;
+    spin_lock_irqsave(&console_lock, flags);
     clear();
     screen_x[current_terminal] = 0;
     screen_y[current_terminal] = 0;
     update_cursor(screen_x[current_terminal], screen_y[current_terminal]);
+    spin_unlock_irqrestore(&console_lock, flags);
     return;
 }
 
@@ -6,6 +6,7 @@
 #define _LIB_H
 
 #include "types.h"
+#include "spinlock.h"
 #include "terminal.h"
 
 #define VIDEO       0xB8000
@@ -18,6 +19,9 @@
 extern int screen_x[TERMINAL_COUNT];
 extern int screen_y[TERMINAL_COUNT];
 
+// held while writing to the screen, every CPU prints to the same one
+extern spinlock_t console_lock;
+
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
 int32_t puts(int8_t *s);
@@ -89,6 +93,30 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the 64-bit time-stamp counter */
+static inline uint64_t rdtsc(void) {
+    uint64_t val;
+    asm volatile ("rdtsc"
+            : "=A"(val)
+    );
+    return val;
+}
+
+/* Divides a 64-bit number by a 32-bit one without libgcc, the quotient
+ * must fit in 32 bits, the remainder goes to rem unless it is NULL */
+static inline uint32_t div64_32(uint64_t n, uint32_t d, uint32_t* rem) {
+    uint32_t q, r;
+    asm ("divl %4"
+            : "=a"(q), "=d"(r)
+            : "a"((uint32_t)n), "d"((uint32_t)(n >> 32)), "rm"(d)
+            : "cc"
+    );
+    if (rem != NULL) {
+        *rem = r;
+    }
+    return q;
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
@@ -1,7 +1,33 @@
 #include "lib.h"
 #include "paging.h"
 #include "types.h"
+#include "buddy.h"
+#include "spinlock.h"
+#include "clock.h"
 
+page_directory_entry_t page_directory[ENTRIES] __attribute__((aligned(4096)));
+page_table_entry_t page_table[ENTRIES] __attribute__((aligned(4096)));
+page_table_entry_t* vid_tables[TERMINAL_PAGES];
+page_table_entry_t* time_table;
+tlb_stats_t tlb_stats;
+
+// Invalidates the TLB entry for one page
+// Inputs: vaddr - any address inside the page
+// Outputs: None
+// Effects: also drops cached paging structures, other translations are kept
+static inline void invlpg(uint32_t vaddr)
+{
+    asm volatile("invlpg (%0)" : : "r"(vaddr) : "memory");
+    atomic_inc(&tlb_stats.invlpgs);
+}
+
+// Returns the page directory loaded in CR3
+static inline page_directory_entry_t* current_page_directory()
+{
+    page_directory_entry_t* pd;
+    asm volatile("movl %%cr3, %0" : "=r"(pd));
+    return pd;
+}
 
 /*
  * Function: Initializes the page directory and page table for a paging system.
@@ -24,7 +50,7 @@ void page_init() {
         page_directory[i].acc = 0; // Page has not been accessed since last refresh
         page_directory[i].avl = 0; // For software use, set to 0
         page_directory[i].ps = 1; // Pages are 4MB in size
-        page_directory[i].g = 1; // Page level cache disable bit
+        page_directory[i].g = (i < KERNEL_PDE_END); // Kernel pages are global, they survive CR3 loads
         page_directory[i].avl_3 = 0; // For software use, set to 0
 
         // Initialize each entry in the page table
@@ -36,12 +62,13 @@ void page_init() {
         page_table[i].acc = 0; // Page has not been accessed since last refresh
         page_table[i].dirty = 0; // Page has not been written to since last refresh
         page_table[i].pat = 0; // Page attribute table index (set to zero)
-        page_table[i].g = 0; // Global flag (ignored)
+        page_table[i].g = 0; // Global flag, set below for the pages that are mapped
         page_table[i].avl_3 = 0; // For software use, set to 0
         page_table[i].addy = i; // Address of the physical frame
 
         if (i << SHIFT_12 == VIDEO_START) {
             page_table[i].present = 1; // If this is the video memory address, mark it as present in memory
+            page_table[i].g = 1; // Kernel mapping, keep it across CR3 loads
         }
 
         if (i == 0) {
@@ -60,7 +87,30 @@ void page_init() {
                12 bits */
             page_directory[i].addy = ( (uint32_t) KERNEL_START ) >> SHIFT_12;
         } 
+
+        else if (i >= DIRECT_MAP_START_IDX && i < DIRECT_MAP_END_IDX) {
+            // identity map the memory handed out by the buddy allocator
+            // kernel only, user programs never see these pages
+            page_directory[i].present = 1;
+            page_directory[i].addy = (i << SHIFT_22) >> SHIFT_12;
+        }
+    }
+
+    // the user video memory page tables come from the frame allocator,
+    // terminal 0 is on screen at boot
+    for(i = 0; i < TERMINAL_PAGES; i++){
+        vid_tables[i] = (page_table_entry_t*)alloc_pages(ORDER_4KB);
+        memset(vid_tables[i], 0, sizeof(page_table_entry_t) * ENTRIES);
+        vid_tables[i][0].present = vid_tables[i][0].rw = vid_tables[i][0].us = 1;
+        vid_tables[i][0].addy = (i == 0) ? VIDEO_START >> SHIFT_12 : (VIDEO_PAGES >> SHIFT_12) + i;
     }
+
+    // the time page is read-only to users, the kernel writes it through the direct map
+    time_table = (page_table_entry_t*)alloc_pages(ORDER_4KB);
+    memset(time_table, 0, sizeof(page_table_entry_t) * ENTRIES);
+    time_table[0].present = time_table[0].us = 1;
+    time_table[0].addy = alloc_pages(ORDER_4KB) >> SHIFT_12;
+    memset((void*)(time_table[0].addy << SHIFT_12), 0, PAGE_SIZE);
     
     // setup pages for terminal video memory
     for(i = VIDEO_PAGES >> SHIFT_12; i < ((VIDEO_PAGES >> SHIFT_12) + TERMINAL_PAGES); i++){
@@ -72,7 +122,7 @@ void page_init() {
         page_table[i].acc = 0; // Page has not been accessed since last refresh
         page_table[i].dirty = 0; // Page has not been written to since last refresh
         page_table[i].pat = 0; // Page attribute table index (set to zero)
-        page_table[i].g = 0; // Global flag (ignored)
+        page_table[i].g = 1; // Same in every address space
         page_table[i].avl_3 = 0; // For software use, set to 0
         page_table[i].addy = i; // Address of the physical frame
     }
@@ -81,7 +131,8 @@ void page_init() {
 
 /*
  * Function: enabling
- * Description: Loads the page directory into the CR3 register and enables paging by setting the PG and PE bits of the CR0 register and PSE (4 MiB pages) by setting PSE bit of CR4 register.
+ * Description: Loads the page directory into the CR3 register and enables paging by setting the PG, WP and PE bits of the CR0 register and PSE (4 MiB pages) by setting PSE bit of CR4 register.
+ *              PGE is set once paging is on so global pages are kept when CR3 is reloaded.
  * Input: Pointer to the page directory.
  * Output: None
  * Side Effects: Modifies the CR0, CR3, and CR4 registers.
@@ -107,15 +158,26 @@ void enabling(unsigned int *page_directory) {
         : "%eax"
     );
     // Enable paging by setting the PG and PE bits of the CR0 register
+    // WP makes the kernel fault on read-only user pages too, copy-on-write depends on it
     asm volatile
     (
         "mov %%cr0, %%eax           ;"    
-        "or $0x80000001, %%eax      ;"  
+        "or $0x80010001, %%eax      ;"  
         "mov %%eax, %%cr0           ;" 
         :
         : 
         : "%eax"
     );    
+    // Enable PGE (global pages)
+    asm volatile 
+    (
+        "mov %%cr4, %%eax           ;" 
+        "or $0x00000080, %%eax      ;"  
+        "mov %%eax, %%cr4           ;"           
+        :
+        : 
+        : "%eax"
+    );
 }
 
 
@@ -129,6 +191,7 @@ void enabling(unsigned int *page_directory) {
 // Effects: Clears TLB
 void flush_tlb()
 {
+    atomic_inc(&tlb_stats.full_flushes);
     asm volatile( "movl %%cr3, %%eax;" 
                   "movl %%eax, %%cr3;"
                 : // no outputs
@@ -136,3 +199,95 @@ void flush_tlb()
                 : "memory", "cc"  // clobbered
                 );
 }
+
+// Allocates a page directory for a process
+// Inputs: None
+// Outputs: the new directory, or NULL if there is no memory
+// Effects: copies the kernel entries of page_directory, user entries start out not present
+page_directory_entry_t* new_page_directory()
+{
+    page_directory_entry_t* pd = (page_directory_entry_t*)alloc_pages(ORDER_4KB);
+    if(pd == NULL){
+        return NULL;
+    }
+    memset(pd, 0, sizeof(page_directory_entry_t) * ENTRIES);
+    memcpy(pd, page_directory, sizeof(page_directory_entry_t) * KERNEL_PDE_END);
+    // one page table shared by every process, its entry is read-only
+    pd[TIME_IDX].present = pd[TIME_IDX].us = 1;
+    pd[TIME_IDX].addy = (uint32_t)time_table >> SHIFT_12;
+    return pd;
+}
+
+// Frees a page directory from new_page_directory
+// Inputs: pd - directory to free, must not be loaded in CR3
+// Outputs: None
+// Effects: the page tables it points to are not freed
+void free_page_directory(page_directory_entry_t* pd)
+{
+    free_pages((uint32_t)pd, ORDER_4KB);
+}
+
+// Switches address spaces
+// Inputs: pd - page directory to load into CR3
+// Outputs: None
+// Effects: flushes every non-global TLB entry
+void load_page_directory(page_directory_entry_t* pd)
+{
+    atomic_inc(&tlb_stats.cr3_loads);
+    asm volatile( "movl %0, %%cr3;"
+                : // no outputs
+                : "r"(pd)
+                : "memory"
+                );
+}
+
+// Changes one page directory entry
+// Inputs: pd - page directory to change
+//         idx - index of the entry
+//         entry - new value
+// Outputs: None
+// Effects: invalidates whatever the old entry mapped, but only if pd is loaded
+//          the next CR3 load takes care of directories that are not
+void set_pde(page_directory_entry_t* pd, uint32_t idx, page_directory_entry_t entry)
+{
+    page_directory_entry_t old = pd[idx];
+    page_table_entry_t* pt;
+    uint32_t i;
+
+    pd[idx] = entry;
+
+    // not-present entries are never cached
+    if(!old.present || pd != current_page_directory()){
+        return;
+    }
+    atomic_inc(&tlb_stats.flushes_avoided);
+    if(old.ps){
+        invlpg(idx << SHIFT_22);
+        return;
+    }
+    // page tables come from the frame allocator or the kernel image, both direct-mapped
+    pt = (page_table_entry_t*)(old.addy << SHIFT_12);
+    for(i = 0; i < ENTRIES; i++){
+        if(pt[i].present){
+            invlpg((idx << SHIFT_22) | (i << SHIFT_12));
+        }
+    }
+}
+
+// Changes one page table entry
+// Inputs: pt - page table to change
+//         vaddr - virtual address the entry maps
+//         entry - new value
+// Outputs: None
+// Effects: invalidates vaddr if it was mapped
+void set_pte(page_table_entry_t* pt, uint32_t vaddr, page_table_entry_t entry)
+{
+    uint32_t idx = (vaddr >> SHIFT_12) & (ENTRIES - 1);
+    page_table_entry_t old = pt[idx];
+
+    pt[idx] = entry;
+    if(old.present){
+        atomic_inc(&tlb_stats.flushes_avoided);
+        invlpg(vaddr);
+    }
+}
@@ -1,6 +1,8 @@
 #ifndef _PAGING_H
 #define _PAGING_H
 
+#include "types.h"
+
 // Define the number of pages and the size of each page
 #define ENTRIES     1024
 #define SHIFT_12   12
@@ -12,6 +14,13 @@
 #define TERMINAL_PAGES 3
 #define KERNEL_START   0x400000
 
+// physical memory above the kernel is identity-mapped with 4MB kernel pages
+// so frames from the buddy allocator can be used directly
+#define DIRECT_MAP_START_IDX 2
+#define DIRECT_MAP_END_IDX   32
+// entries below this are the same in every page directory and marked global
+#define KERNEL_PDE_END       DIRECT_MAP_END_IDX
+
 // info for structures from https://wiki.osdev.org/Paging
 // Define the structure for a page directory entry
 typedef struct __attribute__((packed)) page_directory_entry_t {
@@ -43,15 +52,43 @@ typedef struct __attribute__((packed)) page_table_entry_t {
     unsigned int addy : 20;   // Physical address of the page frame in memory 
 } page_table_entry_t;
 
+// TLB maintenance counters, reported by kstat(KSTAT_TLB)
+typedef struct tlb_stats_t {
+    uint32_t full_flushes;      // CR3 reloads through flush_tlb
+    uint32_t cr3_loads;         // address space switches
+    uint32_t invlpgs;           // single pages invalidated
+    uint32_t flushes_avoided;   // mapping changes handled without a full flush
+} tlb_stats_t;
+
+extern tlb_stats_t tlb_stats;
+
 // Declare the page directory and page tables, aligning them to a boundary of 4096 bytes (the size of a page)
-page_directory_entry_t page_directory[ENTRIES] __attribute__((aligned(4096)));
-page_table_entry_t page_table[ENTRIES] __attribute__((aligned(4096))); 
-page_table_entry_t vid_table[ENTRIES] __attribute__((aligned(4096))); 
+// page_directory only has the kernel mappings, every process gets a copy from new_page_directory
+extern page_directory_entry_t page_directory[ENTRIES];
+extern page_table_entry_t page_table[ENTRIES];
+// page tables for user video memory, one per terminal, allocated from the buddy allocator
+// a process's vidmap uses its terminal's table, which points at the screen while
+// the terminal is shown and at the terminal's backing page otherwise
+extern page_table_entry_t* vid_tables[TERMINAL_PAGES];
+// page table of the time page, every page directory maps it at USER_TIME_PAGE
+extern page_table_entry_t* time_table;
 
 // Function prototypes for initializing paging, loading the page directory, enabling paging, and flushing the TLB.
 extern void page_init();
 extern void enabling(unsigned int *page_directory);
 extern void flush_tlb();
 
+// per-process page directories
+// a new directory shares the kernel entries and has no user mappings
+extern page_directory_entry_t* new_page_directory();
+extern void free_page_directory(page_directory_entry_t* pd);
+// loads pd into CR3, global kernel entries stay in the TLB
+extern void load_page_directory(page_directory_entry_t* pd);
+
+// change one mapping and invalidate only the pages it covered
+// set_pde only touches the TLB if pd is the loaded directory
+extern void set_pde(page_directory_entry_t* pd, uint32_t idx, page_directory_entry_t entry);
+extern void set_pte(page_table_entry_t* pt, uint32_t vaddr, page_table_entry_t entry);
+
 #endif /* PAGING_H */
 
@@ -2,9 +2,15 @@
 // most code from https://wiki.osdev.org/RTC
 
 #include "rtc.h"
+#include "wait_queue.h"
+#include "spinlock.h"
 
 
-volatile int rtc_interrupt_received;
+// number of RTC interrupts so far, readers sleep on rtc_wq until it changes
+volatile uint32_t rtc_ticks;
+static wait_queue_t rtc_wq;
+// the CMOS index and data ports are one pair for every CPU
+static spinlock_t rtc_lock = SPINLOCK_INIT;
 
 // initialization function for RTC
 // sends interrupt request to PIC
@@ -12,6 +18,8 @@ volatile int rtc_interrupt_received;
 // Outputs: none
 // Effects: initializes rtc
 void rtc_init(void){
+    wq_init(&rtc_wq);
+
     // link RTC to PIC
     enable_irq(RTC_IRQ);
 
@@ -45,17 +53,22 @@ void rtc_init(void){
 void rtc_irq_handler(void){
     // stop interrupts while handling this interrupt
     cli();
+    uint32_t start = irq_stats_enter();
 
     // select register C
+    spin_lock(&rtc_lock);
     outb(RegC, CMOS_PORT);
     // get rid of contents
     inb(CMOS_DATA_PORT);
+    spin_unlock(&rtc_lock);
 
     // comment/uncomment below for RTC testing
     // test_interrupts();
 
     send_eoi(RTC_IRQ);
-    rtc_interrupt_received = 1;
+    rtc_ticks++;
+    wq_wake_all(&rtc_wq);
+    irq_stats_exit(RTC_IRQ, start);
 
     // enable interrupts at this point
     sti();
@@ -68,13 +81,16 @@ void rtc_irq_handler(void){
 // Outputs: Returns 0 on success, -1 if filename is NULL.
 // Effects: Sets RTC frequency to 2Hz and enables RTC IRQ.
 int32_t rtc_open(const uint8_t* filename){
+    uint32_t flags;
     if(filename == NULL){
         return -1;
     }   
+    spin_lock_irqsave(&rtc_lock, flags);
     outb(STATUS_REG_A, CMOS_PORT);		// set index to register A, disable NMI
     char prev=inb(CMOS_DATA_PORT);	// get initial value of register A
     outb(STATUS_REG_A, CMOS_PORT);		// reset index to A
     outb((prev & 0xF0) | 0x0F, CMOS_DATA_PORT); //write only our rate to A. Note, rate is the bottom 4 bits. 0x0F and 0xF0 is for masking        
+    spin_unlock_irqrestore(&rtc_lock, flags);
     enable_irq(RTC_IRQ);                   
     return 0;
 }
@@ -88,14 +104,13 @@ int32_t rtc_close(int32_t fd){
 }
 
 // Function: rtc_read
-// Inputs: fd, buf, nbytes
+// Inputs: file, buf, nbytes
 // Outputs: Returns 0 after an RTC interrupt is received.
 // Effects: This function blocks the execution until an RTC interrupt is received.
-int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
-    // Wait until an RTC interrupt is received
-    while(!rtc_interrupt_received);
-    // Reset the interrupt flag
-    rtc_interrupt_received = 0;
+int32_t rtc_read(struct file_descriptor_t* file, void* buf, int32_t nbytes){
+    // Sleep until the next RTC interrupt is received
+    uint32_t start = rtc_ticks;
+    wait_event(&rtc_wq, rtc_ticks != start);
     // Return success
     return 0;
 }
@@ -130,12 +145,13 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){
     char freq_values[10] = {0x0F, 0x0E, 0x0D, 0x0C, 0x0B, 0x0A, 0x09, 0x08, 0x07, 0x06}; //, 0x06
     char freq = freq_values[index];    // Get the correct value to set RS bits in Register A
 
-    cli();    // Block interrupts when writing to RTC
+    uint32_t flags;
+    spin_lock_irqsave(&rtc_lock, flags);    // Block interrupts and the other CPUs when writing to RTC
     outb(STATUS_REG_A, CMOS_PORT);    // Select register A and disable NMI
     char prev = inb(CMOS_DATA_PORT) & 0xF0;    // Get the contents of register A and clear the bottom 4 bits
     outb(STATUS_REG_A, CMOS_PORT);    // Select register A again
     outb(prev | freq, CMOS_DATA_PORT);    // Write the new frequency value to the bottom 4 bits of register A
-    sti();    // Allow interrupts again
+    spin_unlock_irqrestore(&rtc_lock, flags);    // Allow interrupts again
     return 0;
 }
 
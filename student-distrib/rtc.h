@@ -5,6 +5,7 @@
 #include "types.h"
 #include "i8259.h"
 #include "lib.h"
+#include "irq_stats.h"
 
 #define RTC_IRQ 8
 
@@ -33,7 +34,8 @@ void rtc_irq_handler(void);
 // helper functions for system call functionality
 int32_t rtc_open(const uint8_t* filename);
 int32_t rtc_close(int32_t fd);
-int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
+struct file_descriptor_t;
+int32_t rtc_read(struct file_descriptor_t* file, void* buf, int32_t nbytes);
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 
 
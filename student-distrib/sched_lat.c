@@ -0,0 +1,86 @@
+// wakeup latency tracer
+// sched_wakeup timestamps a process when it goes on a run queue, schedule
+// measures how long it waited when it finally gets a CPU
+
+#include "sched_lat.h"
+#include "systemcall.h"
+
+// every process combined, and the worst wakeups so far, worst first
+static sched_lat_t lat_all;
+static lat_trace_t lat_worst[LAT_TRACES];
+// protects both, taken with a run queue lock held
+static spinlock_t lat_lock = SPINLOCK_INIT;
+
+// Description: adds a sample to a histogram
+// Inputs: lat - histogram to add to
+//         us - latency in microseconds
+// Outputs: none
+static void sched_lat_add(sched_lat_t* lat, uint32_t us){
+    uint32_t bucket = syscall_stats_bucket(us);
+
+    lat->count++;
+    if(us > lat->max_us){
+        lat->max_us = us;
+    }
+    lat->hist[(bucket < LAT_BUCKETS) ? bucket : LAT_BUCKETS - 1]++;
+}
+
+// Description: stamps a process that just became runnable
+// Inputs: pcb - process sched_wakeup queued
+// Outputs: none
+// Effects: its run queue is locked, so schedule cannot pick it up halfway
+void sched_lat_wake(pcb_t* pcb){
+    pcb->wake_ns = clock_ns();
+    pcb->wake_cpu = this_cpu()->id;
+    pcb->wake_pending = 1;
+}
+
+// Description: measures the wait of a process that gets the CPU
+// Inputs: prev - process the CPU switches away from
+//         next - process it switches to
+// Outputs: none
+// Effects: a slow enough wakeup replaces the least bad of the worst traces
+void sched_lat_run(pcb_t* prev, pcb_t* next){
+    uint64_t ns;
+    uint32_t us, i;
+
+    if(!next->wake_pending){
+        return;
+    }
+    next->wake_pending = 0;
+    ns = clock_ns() - next->wake_ns;
+    us = (ns >> 32) ? LAT_MAX_US : (uint32_t)ns / NS_PER_US;
+
+    // the process is only on this CPU, nobody else touches its numbers
+    sched_lat_add(&next->sched_lat, us);
+
+    spin_lock(&lat_lock);
+    sched_lat_add(&lat_all, us);
+    if(us > lat_worst[LAT_TRACES - 1].latency_us){
+        for(i = LAT_TRACES - 1; i > 0 && us > lat_worst[i - 1].latency_us; i--){
+            lat_worst[i] = lat_worst[i - 1];
+        }
+        lat_worst[i].pid = next->pid;
+        strncpy(lat_worst[i].name, (int8_t*)next->name, LAT_NAME_LEN - 1);
+        lat_worst[i].name[LAT_NAME_LEN - 1] = '\0';
+        lat_worst[i].latency_us = us;
+        lat_worst[i].ticks = pit_ticks;
+        lat_worst[i].priority = next->priority;
+        lat_worst[i].wake_cpu = next->wake_cpu;
+        lat_worst[i].cpu = this_cpu()->id;
+        lat_worst[i].prev_pid = prev->pid;
+    }
+    spin_unlock(&lat_lock);
+}
+
+// Description: copies what the tracer found
+// Inputs: report - where to put it
+// Outputs: none
+void sched_lat_get(sched_lat_report_t* report){
+    uint32_t flags;
+
+    spin_lock_irqsave(&lat_lock, flags);
+    report->all = lat_all;
+    memcpy(report->worst, lat_worst, sizeof(lat_worst));
+    spin_unlock_irqrestore(&lat_lock, flags);
+}
@@ -0,0 +1,60 @@
+// wakeup latency tracer header file
+#ifndef _SCHED_LAT_H
+#define _SCHED_LAT_H
+
+#include "types.h"
+
+// bucket i counts latencies of [2^i, 2^(i+1)) microseconds, the last one
+// everything longer, bucket 0 also takes anything under a microsecond
+#define LAT_BUCKETS     20
+// the worst wakeups are kept with what was going on around them
+#define LAT_TRACES      8
+// names in a trace are cut to this, with the terminating zero
+#define LAT_NAME_LEN    16
+// a wait longer than this is counted as this
+#define LAT_MAX_US      0xFFFFFFFF
+
+// time from becoming runnable to getting the CPU
+// a process that is preempted is not counted, only new and woken ones
+typedef struct sched_lat_t {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t hist[LAT_BUCKETS];
+} sched_lat_t;
+
+// one of the worst wakeups
+typedef struct lat_trace_t {
+    int32_t pid;
+    int8_t name[LAT_NAME_LEN];
+    uint32_t latency_us;
+    // pit_ticks when it got the CPU
+    uint32_t ticks;
+    // MLFQ level it ran at
+    uint32_t priority;
+    // CPU that made it runnable and the one it ran on
+    uint32_t wake_cpu;
+    uint32_t cpu;
+    // process it took the CPU from, -1 for the idle task
+    int32_t prev_pid;
+} lat_trace_t;
+
+// what kstat(KSTAT_SCHED_LAT) returns
+typedef struct sched_lat_report_t {
+    // every process combined
+    sched_lat_t all;
+    // worst first, unused entries have a latency of 0
+    lat_trace_t worst[LAT_TRACES];
+} sched_lat_report_t;
+
+struct pcb_t;
+
+// called by sched_wakeup once the process is on a run queue
+extern void sched_lat_wake(struct pcb_t* pcb);
+
+// called by schedule when it switches from prev to next, with the run queue locked
+extern void sched_lat_run(struct pcb_t* prev, struct pcb_t* next);
+
+// copies the global histogram and the worst traces
+extern void sched_lat_get(sched_lat_report_t* report);
+
+#endif /* _SCHED_LAT_H */
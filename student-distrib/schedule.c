@@ -5,7 +5,94 @@
 #include "paging.h"
 #include "file_sys.h"
 
-int temp_terminal = 0;
+#include "schedule_wrapper.h"
+#include "timer.h"
+#include "fpu.h"
+#include "smp.h"
+#include "lapic.h"
+#include "clock.h"
+
+// one idle task per CPU, it runs cpu_idle when nothing else is runnable there
+// they have no pid, so current_pcb() is NULL while they run
+// the boot context becomes the idle task of CPU 0
+pcb_t idle_tasks[NR_CPUS];
+
+// run queue of each CPU
+static runqueue_t runqueues[NR_CPUS];
+
+// ticks since every process was last moved back to the top level, CPU 0 counts them
+static uint32_t boost_ticks;
+// set when every CPU's local APIC timer is the tick, the PIT is only the fallback
+static uint8_t lapic_tick;
+
+// current scheduler tunables, see sched_tunables_t
+sched_tunables_t sched_tunables = {
+    .quantum = MLFQ_DEFAULT_QUANTA,
+    .boost_interval = MLFQ_DEFAULT_BOOST,
+    .io_boost = MLFQ_DEFAULT_IO_BOOST,
+    .share = {FAIR_DEFAULT_SHARE, FAIR_DEFAULT_SHARE, FAIR_DEFAULT_SHARE}
+};
+
+// virtual time of each terminal's group, it advances while the group's
+// processes run, the more slowly the larger its share, and the group that is
+// furthest behind runs next, on every CPU
+static uint32_t fair_vtime[FAIR_GROUPS];
+// ticks each group used
+static uint32_t fair_ticks[FAIR_GROUPS];
+// virtual time of the group picked last, a group that wakes up starts close to it
+static uint32_t fair_clock;
+// protects the three above, taken with a run queue lock held
+static spinlock_t fair_lock = SPINLOCK_INIT;
+
+// what the PIT is doing, the idle task stops the periodic tick
+// only with a single CPU, the others get their tick from the PIT too
+enum pit_state_t {
+    PIT_PERIODIC,   // mode 3, one interrupt per tick
+    PIT_ONESHOT,    // mode 0, armed for one interrupt
+    PIT_EXPIRED,    // mode 0, the one-shot fired and was not armed again
+    PIT_STOPPED     // mode 0 with no count, no interrupts at all
+};
+static enum pit_state_t pit_state = PIT_PERIODIC;
+// PIT clocks left of the one-shot when we last looked at it
+static uint32_t oneshot_left;
+// PIT clocks since the last whole tick
+static uint32_t pit_rem;
+// TSC when the PIT was stopped, it tells how long we slept
+static uint64_t pit_stop_tsc;
+
+static void sched_tick(uint32_t cs, uint32_t ticks);
+static void sched_boost();
+static uint32_t rq_stealable(runqueue_t* rq);
+static uint32_t rq_has_work(runqueue_t* rq);
+static void dl_charge(runqueue_t* rq, pcb_t* pcb, uint64_t now);
+
+// Description: Checks whether the idle task may stop the tick
+// Inputs: None
+// Outputs: nonzero if it may
+// Effects: only the PIT tick can be stopped, and only if no other CPU lives off it
+static uint32_t nohz_allowed(){
+    return nr_cpus == 1 && !lapic_tick;
+}
+
+// Description: Counts ticks towards the next priority boost
+// Inputs: ticks - ticks that passed
+// Outputs: None
+// Effects: called on CPU 0 only
+static void sched_boost_tick(uint32_t ticks){
+    boost_ticks += ticks;
+    if(boost_ticks >= sched_tunables.boost_interval){
+        boost_ticks = 0;
+        sched_boost();
+    }
+}
+
+// Description: Finds the run queue of the calling CPU
+// Inputs: None
+// Outputs: its run queue
+// Effects: interrupts must be off, or we could be moved to another CPU
+static runqueue_t* this_rq(){
+    return &runqueues[this_cpu()->id];
+}
 
 // Description: Initializes the PIT to schedule a timer interrupt every 20 milliseconds
 // Inputs: None
@@ -16,87 +103,1137 @@ void PIT_init(){
     outb(CHANNEL_MODE, COMMAND_REG); // select mode and command
     outb(COUNT&0xFF, CHANNEL_0_DATA_PORT);        // send Low byte
     outb((COUNT&0xFF00)>>8, CHANNEL_0_DATA_PORT);    // send High byte
+    pit_state = PIT_PERIODIC;
     enable_irq(0);
     return;
 }
 
+// Description: Arms the PIT for a single interrupt
+// Inputs: count - PIT clocks until the interrupt, at most MAX_PIT_COUNT
+// Outputs: None
+// Effects: stops the periodic tick
+static void pit_oneshot(uint32_t count){
+    outb(ONESHOT_MODE, COMMAND_REG);
+    outb(count&0xFF, CHANNEL_0_DATA_PORT);
+    outb((count&0xFF00)>>8, CHANNEL_0_DATA_PORT);
+    oneshot_left = count;
+    pit_state = PIT_ONESHOT;
+}
+
+// Description: Reads how far the PIT is into the current periodic tick
+// Inputs: None
+// Outputs: PIT clocks since the last tick
+static uint32_t pit_periodic_elapsed(){
+    uint8_t status;
+    uint32_t count;
+
+    outb(READBACK_CMD, COMMAND_REG);
+    status = inb(CHANNEL_0_DATA_PORT);
+    count = inb(CHANNEL_0_DATA_PORT);
+    count |= inb(CHANNEL_0_DATA_PORT) << 8;
+    // mode 3 counts down by two, twice per tick, the output is high during the first half
+    if(status & STATUS_OUT){
+        return (COUNT - count) / 2;
+    }
+    return COUNT / 2 + (COUNT - count) / 2;
+}
+
+// Description: Adds PIT clocks to the time since the last whole tick
+// Inputs: clocks - PIT clocks that passed
+// Outputs: whole ticks that passed
+static uint32_t pit_account(uint32_t clocks){
+    uint32_t ticks;
+
+    pit_rem += clocks;
+    ticks = pit_rem / COUNT;
+    pit_rem %= COUNT;
+    return ticks;
+}
+
+// Description: Counts the time that passed since the one-shot was last looked at
+// Inputs: None
+// Outputs: whole ticks that passed
+// Effects: oneshot_left is 0 if the one-shot fired and its interrupt is still pending
+static uint32_t pit_oneshot_account(){
+    uint32_t left;
+
+    // latch the count, in mode 0 it keeps counting down past zero
+    outb(LATCH_CMD, COMMAND_REG);
+    left = inb(CHANNEL_0_DATA_PORT);
+    left |= inb(CHANNEL_0_DATA_PORT) << 8;
+    if(left > oneshot_left){
+        left = 0;
+    }
+    left = oneshot_left - left;
+    oneshot_left -= left;
+    return pit_account(left);
+}
+
+// Description: Counts the time that passed since the PIT was stopped
+// Inputs: None
+// Outputs: whole ticks that passed
+// Effects: nothing can be told without a TSC, the time is lost then
+static uint32_t pit_stopped_account(){
+    uint64_t cycles;
+    uint32_t ticks, rem;
+
+    if(time_page->tsc_per_tick == 0){
+        return 0;
+    }
+    cycles = rdtsc() - pit_stop_tsc;
+    ticks = div64_32(cycles, time_page->tsc_per_tick, &rem);
+    rem = div64_32((uint64_t)rem * COUNT, time_page->tsc_per_tick, NULL);
+    return ticks + pit_account(rem);
+}
+
+// Description: Catches up on the ticks the idle task slept through
+// Inputs: ticks - ticks that passed without a PIT interrupt
+// Outputs: None
+// Effects: runs expired timers, which may wake processes up
+static void nohz_catch_up(uint32_t ticks){
+    idle_tasks[0].cpu_stats.kernel_ticks += ticks;
+    timer_advance(ticks);
+}
+
+// Description: Replaces the periodic tick with one interrupt at the next
+//              timer deadline, or none at all if no timer is pending
+// Inputs: None
+// Outputs: None
+// Effects: called by the idle task with interrupts off
+static void nohz_enter(){
+    uint32_t expires, ticks, count;
+
+    if(pit_state == PIT_PERIODIC){
+        pit_rem = pit_periodic_elapsed();
+    } else if(pit_state == PIT_ONESHOT){
+        nohz_catch_up(pit_oneshot_account());
+        if(oneshot_left == 0){
+            // its interrupt is pending, the handler counts the rest
+            return;
+        }
+    }
+    if(rq_has_work(&runqueues[0])){
+        return;
+    }
+
+    if(timer_next_expiry(&expires) == -1){
+        // nothing needs the time until an interrupt makes a process runnable
+        outb(ONESHOT_MODE, COMMAND_REG);
+        pit_stop_tsc = rdtsc();
+        pit_state = PIT_STOPPED;
+        return;
+    }
+    ticks = expires - pit_ticks;
+    if((int32_t)ticks < 1){
+        ticks = 1;
+    } else if(ticks > NOHZ_MAX_TICKS){
+        ticks = NOHZ_MAX_TICKS;
+    }
+    count = ticks * COUNT - pit_rem;
+    if(count > MAX_PIT_COUNT){
+        count = MAX_PIT_COUNT;
+    }
+    pit_oneshot(count);
+}
+
+// Description: Brings the tick back when the idle task is about to stop
+// Inputs: None
+// Outputs: None
+// Effects: runs expired timers, the periodic tick restarts on the next tick boundary
+static void nohz_exit(){
+    switch(pit_state){
+        case PIT_PERIODIC:
+            return;
+        case PIT_STOPPED:
+            nohz_catch_up(pit_stopped_account());
+            break;
+        case PIT_ONESHOT:
+            nohz_catch_up(pit_oneshot_account());
+            if(oneshot_left == 0){
+                // the pending interrupt sees a process running and restarts the tick
+                return;
+            }
+            break;
+        case PIT_EXPIRED:
+            break;
+    }
+    // one more one-shot to the next tick boundary, its handler goes periodic
+    pit_oneshot(COUNT - pit_rem);
+}
+
 // Function: pit_irq_handler
 // Description: Handles PIT(programmable interval timer) interrupts for scheduling.
-// Inputs: None
+// Inputs: cs - code segment the interrupt came from, tells user from kernel time
 // Outputs: None
-void pit_irq_handler() {
-    cli();
+// Effects: only CPU 0 gets these, it passes each tick on to the other CPUs
+void pit_irq_handler(uint32_t cs) {
+    uint32_t start = irq_stats_enter();
+    uint32_t ticks = 1;
+    runqueue_t* rq = this_rq();
     send_eoi(0);
 
-    // If the current terminal is not active, initialize it and execute a shell
-    if (terminal_array[temp_terminal].on_off_flag == 0) {
-        terminal_array[temp_terminal].on_off_flag = 1;
-        int prev_terminal = current_terminal;
-        open_terminal(temp_terminal);     
+    if(pit_state == PIT_ONESHOT){
+        ticks = pit_account(oneshot_left);
+        oneshot_left = 0;
+        // the idle task arms the next one-shot itself, anyone else needs the tick back
+        if(rq->current == rq->idle && !rq_has_work(rq)){
+            pit_state = PIT_EXPIRED;
+        } else {
+            PIT_init();
+        }
+    }
+    timer_advance(ticks);
+    if(nr_cpus > 1){
+        lapic_broadcast_ipi(LAPIC_DM_FIXED | IPI_TICK_VECTOR);
+    }
+    sched_tick(cs, ticks);
+    sched_boost_tick(ticks);
 
-        execute( (uint8_t*)"shell" );
+    // the switch itself is not counted, it would be charged to the next process's tick
+    irq_stats_exit(0, start);
+    if(rq->need_resched){
+        schedule();
+    }
+}
 
-        open_terminal(prev_terminal);
+// Function: lapic_timer_handler
+// Description: Handles the local APIC timer, every CPU's own scheduler tick
+// Inputs: cs - code segment the interrupt came from, tells user from kernel time
+// Outputs: None
+// Effects: CPU 0 also keeps the time, runs the kernel timers and counts the
+//          interrupt as IRQ 0, which the PIT tick used to be
+void lapic_timer_handler(uint32_t cs) {
+    runqueue_t* rq = this_rq();
+    uint32_t bsp = (this_cpu()->id == 0);
+    uint32_t start = 0;
 
-        sti();
+    if(bsp){
+        start = irq_stats_enter();
+    }
+    lapic_eoi();
+    if(bsp){
+        timer_advance(1);
+    }
+    sched_tick(cs, 1);
+    if(bsp){
+        sched_boost_tick(1);
+        irq_stats_exit(0, start);
+    }
+    if(rq->need_resched){
+        schedule();
+    }
+}
+
+// Function: tick_init
+// Description: Starts the scheduler tick on CPU 0, the local APIC timer if it
+//              could be calibrated, the PIT otherwise
+// Inputs: None
+// Outputs: None
+// Effects: the other CPUs started their own timers when they came up
+void tick_init() {
+    if(lapic_timer_count != 0){
+        lapic_tick = 1;
+        lapic_timer_start();
+    } else {
+        PIT_init();
+    }
+}
+
+// Function: ipi_tick_handler
+// Description: Handles the tick CPU 0 passes on to the other CPUs
+// Inputs: cs - code segment the interrupt came from, tells user from kernel time
+// Outputs: None
+void ipi_tick_handler(uint32_t cs) {
+    lapic_eoi();
+    sched_tick(cs, 1);
+    if(this_rq()->need_resched){
+        schedule();
+    }
+}
+
+// Function: ipi_resched_handler
+// Description: Handles another CPU asking us to look at our run queue
+// Inputs: None
+// Outputs: None
+// Effects: an idle CPU that was halted goes back to cpu_idle, which looks for work to take
+void ipi_resched_handler() {
+    lapic_eoi();
+    if(this_rq()->need_resched){
+        schedule();
+    }
+}
+
+// Function: sched_init
+// Description: Turns the boot context into the idle task of CPU 0
+// Inputs: None
+// Outputs: None
+// Effects: must run before any process is created
+void sched_init() {
+    sched_init_cpu();
+}
+
+// Function: sched_init_cpu
+// Description: Turns the calling context into the idle task of this CPU
+// Inputs: None
+// Outputs: None
+// Effects: the CPU's run queue starts out empty
+void sched_init_cpu() {
+    cpu_t* cpu = this_cpu();
+    runqueue_t* rq = &runqueues[cpu->id];
+    pcb_t* idle = &idle_tasks[cpu->id];
+
+    idle->pid = IDLE_PID;
+    idle->parent_pid = IDLE_PID;
+    idle->terminal = KTHREAD_TERMINAL;
+    idle->state = PROC_RUNNABLE;
+    strcpy((int8_t*)idle->name, "idle");
+    if(cpu->id > 0){
+        itoa(cpu->id, (int8_t*)idle->name + strlen("idle"), 10);
+    }
+    idle->cpu = cpu->id;
+    idle->on_cpu = 1;
+
+    rq->idle = rq->current = idle;
+    rq->switch_tsc = rdtsc();
+    cpu->pid = -1;
+}
+
+// Function: cpu_idle
+// Description: Body of the idle task, halts until the next interrupt
+// Inputs: None
+// Outputs: None
+// Effects: never returns
+void cpu_idle() {
+    runqueue_t* rq;
+
+    while(1){
+        cli();
+        rq = this_rq();
+#if TICKLESS_IDLE
+        if(nohz_allowed()){
+            nohz_enter();
+        }
+#endif
+        if(rq_has_work(rq) || rq_stealable(rq)){
+            // a timer we caught up on woke someone, or another CPU has work to spare
+            sti();
+            schedule();
+        } else {
+            asm volatile("sti; hlt");
+        }
+    }
+}
 
+// Function: rq_has_work
+// Description: Checks whether any process is queued on a run queue
+// Inputs: rq - run queue to look at
+// Outputs: nonzero if one is waiting for the CPU
+static uint32_t rq_has_work(runqueue_t* rq) {
+    return rq->bitmap != 0 || rq->dl_head != NULL;
+}
+
+// Function: vtime_before
+// Description: Compares two virtual times, they may have wrapped around
+// Inputs: a, b - virtual times
+// Outputs: nonzero if a is earlier than b
+static uint32_t vtime_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+// Function: rq_queue
+// Description: Finds the queue of a process, its level within its group
+// Inputs: pcb - the process
+// Outputs: index into head and tail of the run queue
+static uint32_t rq_queue(pcb_t* pcb) {
+    return (pcb->terminal + 1) * MLFQ_LEVELS + pcb->priority;
+}
+
+// Function: fair_pick
+// Description: Picks the group to run a process from. Kernel threads go first,
+//              then the terminal whose group is furthest behind.
+// Inputs: rq - locked run queue with processes queued
+// Outputs: the group, 0 for the kernel threads or terminal + 1
+static uint32_t fair_pick(runqueue_t* rq) {
+    uint32_t group, best = 0;
+
+    if(rq->bitmap & RQ_LEVEL_MASK){
+        return 0;
+    }
+    spin_lock(&fair_lock);
+    for(group = 1; group <= FAIR_GROUPS; group++){
+        if(((rq->bitmap >> (group * MLFQ_LEVELS)) & RQ_LEVEL_MASK) &&
+           (best == 0 || vtime_before(fair_vtime[group - 1], fair_vtime[best - 1]))){
+            best = group;
+        }
+    }
+    if(vtime_before(fair_clock, fair_vtime[best - 1])){
+        fair_clock = fair_vtime[best - 1];
+    }
+    spin_unlock(&fair_lock);
+    return best;
+}
+
+// Function: fair_charge
+// Description: Charges ticks to the group of the running process, in virtual
+//              time inversely proportional to its share
+// Inputs: rq - locked run queue of this CPU
+//         pcb - the running process, not a kernel thread or deadline process
+//         ticks - ticks it ran
+// Outputs: None
+// Effects: a group waiting here that fell far enough behind takes over the CPU
+static void fair_charge(runqueue_t* rq, pcb_t* pcb, uint32_t ticks) {
+    uint32_t group;
+
+    spin_lock(&fair_lock);
+    fair_ticks[pcb->terminal] += ticks;
+    fair_vtime[pcb->terminal] += ticks * (FAIR_TICK_VTIME * FAIR_DEFAULT_SHARE) / sched_tunables.share[pcb->terminal];
+    for(group = 0; group < FAIR_GROUPS; group++){
+        if(((rq->bitmap >> ((group + 1) * MLFQ_LEVELS)) & RQ_LEVEL_MASK) &&
+           vtime_before(fair_vtime[group] + FAIR_GRANULARITY, fair_vtime[pcb->terminal])){
+            rq->need_resched = 1;
+        }
+    }
+    spin_unlock(&fair_lock);
+}
+
+// Function: fair_wakeup
+// Description: Brings the group of a process that became runnable up to the
+//              groups that kept running, less FAIR_GRANULARITY so it gets the CPU
+//              soon. A group cannot save up CPU time while it has nothing to do.
+// Inputs: pcb - the process, not a kernel thread
+// Outputs: None
+static void fair_wakeup(pcb_t* pcb) {
+    spin_lock(&fair_lock);
+    if(vtime_before(fair_vtime[pcb->terminal], fair_clock - FAIR_GRANULARITY)){
+        fair_vtime[pcb->terminal] = fair_clock - FAIR_GRANULARITY;
+    }
+    spin_unlock(&fair_lock);
+}
+
+// Function: rq_enqueue
+// Description: Adds a process to the back of its level's queue in its group in O(1).
+//              Kernel threads go to the front of the top level, they do work
+//              interrupt handlers deferred. Deadline processes go on their own
+//              queue in deadline order, unless they are throttled, then their
+//              replenishment queues them.
+// Inputs: rq - locked run queue of the process's CPU
+//         pcb - runnable process that is not on the CPU or a queue
+// Outputs: None
+static void rq_enqueue(runqueue_t* rq, pcb_t* pcb) {
+    uint32_t queue = rq_queue(pcb);
+    pcb_t** link;
+
+    if(pcb->dl_period_us != 0){
+        if(pcb->dl_throttled){
+            return;
+        }
+        for(link = &rq->dl_head; *link != NULL && (*link)->dl_deadline <= pcb->dl_deadline; link = &(*link)->run_next);
+        pcb->run_next = *link;
+        *link = pcb;
         return;
-    }  
-    // Find the next terminal to schedule
-    // 3 is the number of terminals
-    temp_terminal = (temp_terminal + 1) % 3;
-
-    // If the current terminal does not have an active process, return
-    if(terminal_array[temp_terminal].terminal_current_pid < 3){
-        sti(); // Enable interrupts
+    }
+    if(rq->head[queue] == NULL){
+        pcb->run_next = NULL;
+        rq->head[queue] = rq->tail[queue] = pcb;
+    } else if(pcb->terminal == KTHREAD_TERMINAL){
+        pcb->run_next = rq->head[queue];
+        rq->head[queue] = pcb;
+    } else {
+        pcb->run_next = NULL;
+        rq->tail[queue]->run_next = pcb;
+        rq->tail[queue] = pcb;
+    }
+    rq->bitmap |= 1 << queue;
+    if(pcb->terminal != KTHREAD_TERMINAL){
+        rq->nr_movable++;
+    }
+}
+
+// Function: rq_dequeue
+// Description: Takes the deadline process with the earliest deadline, or else
+//              the first process of the highest non-empty level of the group
+//              fair_pick chose, in O(1)
+// Inputs: rq - locked run queue
+// Outputs: the process that should run next, or NULL if there is none
+static pcb_t* rq_dequeue(runqueue_t* rq) {
+    uint32_t queue, group;
+    pcb_t *pcb;
+
+    if(rq->dl_head != NULL){
+        pcb = rq->dl_head;
+        rq->dl_head = pcb->run_next;
+        return pcb;
+    }
+    if(rq->bitmap == 0){
+        return NULL;
+    }
+    group = fair_pick(rq);
+    // the lowest bit from there on is the group's highest level
+    asm volatile("bsfl %1, %0" : "=r"(queue) : "rm"(rq->bitmap >> (group * MLFQ_LEVELS)));
+    queue += group * MLFQ_LEVELS;
+    pcb = rq->head[queue];
+    rq->head[queue] = pcb->run_next;
+    if(rq->head[queue] == NULL){
+        rq->tail[queue] = NULL;
+        rq->bitmap &= ~(1 << queue);
+    }
+    if(pcb->terminal != KTHREAD_TERMINAL){
+        rq->nr_movable--;
+    }
+    return pcb;
+}
+
+// Function: rq_stealable
+// Description: Checks whether another CPU has a process waiting that we could take
+// Inputs: rq - run queue of the calling CPU
+// Outputs: 1 if there is one, 0 otherwise
+// Effects: looks without locking, rq_steal finds out for sure
+static uint32_t rq_stealable(runqueue_t* rq) {
+    uint32_t i;
+
+    for(i = 0; i < nr_cpus; i++){
+        if(&runqueues[i] != rq && runqueues[i].nr_movable > 0){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function: rq_steal
+// Description: Takes the highest priority process another CPU has waiting,
+//              starting with the CPU after ours so the load spreads out
+// Inputs: rq - locked run queue of the calling CPU
+// Outputs: the process, now belonging to this CPU, or NULL if there was none
+// Effects: skips queues that are locked, two idle CPUs stealing from each other
+//          would otherwise deadlock
+static pcb_t* rq_steal(runqueue_t* rq) {
+    runqueue_t* victim;
+    pcb_t *pcb;
+    uint32_t id = rq - runqueues;
+    uint32_t i, level, group, queue;
+
+    for(i = 1; i < nr_cpus; i++){
+        victim = &runqueues[(id + i) % nr_cpus];
+        if(victim->nr_movable == 0 || !spin_trylock(&victim->lock)){
+            continue;
+        }
+        // kernel threads stay on CPU 0, so their group is left alone
+        for(level = 0; level < MLFQ_LEVELS; level++){
+            for(group = 1; group <= FAIR_GROUPS; group++){
+                queue = group * MLFQ_LEVELS + level;
+                pcb = victim->head[queue];
+                if(pcb == NULL){
+                    continue;
+                }
+                victim->head[queue] = pcb->run_next;
+                if(victim->head[queue] == NULL){
+                    victim->tail[queue] = NULL;
+                    victim->bitmap &= ~(1 << queue);
+                }
+                victim->nr_movable--;
+                pcb->cpu = id;
+                spin_unlock(&victim->lock);
+                return pcb;
+            }
+        }
+        spin_unlock(&victim->lock);
+    }
+    return NULL;
+}
+
+// Function: rq_lock_pcb
+// Description: Locks the run queue of the CPU a process belongs to
+// Inputs: pcb - the process
+// Outputs: the locked run queue
+// Effects: interrupts must be off, the process cannot change CPUs until it is unlocked
+static runqueue_t* rq_lock_pcb(pcb_t* pcb) {
+    runqueue_t* rq;
+
+    while(1){
+        rq = &runqueues[pcb->cpu];
+        spin_lock(&rq->lock);
+        // it may have been stolen while we waited
+        if(rq == &runqueues[pcb->cpu]){
+            return rq;
+        }
+        spin_unlock(&rq->lock);
+    }
+}
+
+// Function: sched_pick_cpu
+// Description: Finds the CPU with the fewest processes for a new one
+// Inputs: None
+// Outputs: its id
+static uint32_t sched_pick_cpu() {
+    uint32_t i, load;
+    uint32_t best = 0, best_load = (uint32_t)-1;
+
+    for(i = 0; i < nr_cpus; i++){
+        load = runqueues[i].nr_movable + (runqueues[i].current != runqueues[i].idle);
+        if(load < best_load){
+            best = i;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+// Function: sched_boost
+// Description: Moves every process back to the top level, so CPU hogs that
+//              sank to the bottom cannot be starved forever
+// Inputs: None
+// Outputs: None
+// Effects: called on CPU 0 with interrupts off, queues keep their order
+static void sched_boost() {
+    runqueue_t* rq;
+    pcb_t *pcb;
+    uint32_t top, queue;
+    int i;
+
+    spin_lock(&pid_lock);
+    for(i = 0; i < MAX_PIDS; i++){
+        pcb = get_pcb(i);
+        if(pcb != NULL){
+            rq = rq_lock_pcb(pcb);
+            pcb->priority = 0;
+            pcb->slice_left = 0;
+            spin_unlock(&rq->lock);
+        }
+    }
+    spin_unlock(&pid_lock);
+
+    for(i = 0; i < nr_cpus; i++){
+        rq = &runqueues[i];
+        spin_lock(&rq->lock);
+        // append the lower levels of each group to its top one, highest first
+        rq->bitmap = 0;
+        for(top = 0; top < RQ_QUEUES; top += MLFQ_LEVELS){
+            for(queue = top + 1; queue < top + MLFQ_LEVELS; queue++){
+                if(rq->head[queue] == NULL){
+                    continue;
+                }
+                if(rq->head[top] == NULL){
+                    rq->head[top] = rq->head[queue];
+                } else {
+                    rq->tail[top]->run_next = rq->head[queue];
+                }
+                rq->tail[top] = rq->tail[queue];
+                rq->head[queue] = rq->tail[queue] = NULL;
+            }
+            if(rq->head[top] != NULL){
+                rq->bitmap |= 1 << top;
+            }
+        }
+        // the others notice at their next tick
+        rq->need_resched = 1;
+        spin_unlock(&rq->lock);
+    }
+}
+
+// Function: sched_tick
+// Description: Charges a tick to the process running on this CPU and to its time slice
+// Inputs: cs - code segment the interrupt came from, tells user from kernel time
+//         ticks - ticks the interrupt stands for, more than one after a tickless idle
+// Outputs: None
+// Effects: a process that used up its slice moves down a level and gives up the CPU
+static void sched_tick(uint32_t cs, uint32_t ticks) {
+    runqueue_t* rq = this_rq();
+    pcb_t* cur;
+
+    spin_lock(&rq->lock);
+    cur = rq->current;
+    if((cs & RPL_MASK) == USER_RPL){
+        cur->cpu_stats.user_ticks += ticks;
+    } else {
+        cur->cpu_stats.kernel_ticks += ticks;
+    }
+
+    if(cur == rq->idle){
+        // anything that became runnable takes over from idle
+        rq->need_resched = (rq_has_work(rq) || rq_stealable(rq));
+    } else if(cur->dl_period_us != 0){
+        // deadline processes have a budget instead of a time slice
+        dl_charge(rq, cur, clock_ns());
+    } else if(ticks > 0 && cur->terminal != KTHREAD_TERMINAL && cur->slice_left > 0){
+        fair_charge(rq, cur, ticks);
+        cur->slice_left--;
+        if(cur->slice_left == 0){
+            if(cur->priority < MLFQ_LEVELS - 1){
+                cur->priority++;
+            }
+            rq->need_resched = 1;
+        }
+    }
+    spin_unlock(&rq->lock);
+}
+
+// Function: sched_kick
+// Description: Gets another CPU to look at the process we just queued
+// Inputs: rq - run queue it went on
+//         resched - whether that CPU should switch to it
+// Outputs: None
+// Effects: if the process's own CPU is busy, an idle CPU is woken to steal it
+static void sched_kick(runqueue_t* rq, uint32_t resched) {
+    runqueue_t* self = this_rq();
+    uint32_t i;
+
+    if(resched){
+        if(rq != self){
+            lapic_send_ipi(cpus[rq - runqueues].apic_id, LAPIC_DM_FIXED | IPI_RESCHED_VECTOR);
+        }
+        return;
+    }
+    for(i = 0; i < nr_cpus; i++){
+        if(&runqueues[i] != self && &runqueues[i] != rq && runqueues[i].current == runqueues[i].idle){
+            lapic_send_ipi(cpus[i].apic_id, LAPIC_DM_FIXED | IPI_RESCHED_VECTOR);
+            return;
+        }
+    }
+}
+
+// Function: sched_preempts
+// Description: Checks whether a process that was just queued should take the
+//              CPU from the running one. Deadline processes go before everyone
+//              else, the earlier deadline first. A process of another terminal
+//              takes over if its group is behind, within a group and for kernel
+//              threads the higher level wins.
+// Inputs: rq - locked run queue the process is on
+//         pcb - the process
+// Outputs: nonzero if it should
+static uint32_t sched_preempts(runqueue_t* rq, pcb_t* pcb) {
+    pcb_t* cur = rq->current;
+
+    if(cur == rq->idle){
+        return 1;
+    }
+    if(pcb->dl_period_us != 0){
+        return cur->dl_period_us == 0 || cur->dl_throttled || pcb->dl_deadline < cur->dl_deadline;
+    }
+    if(cur->dl_period_us != 0){
+        return 0;
+    }
+    if(pcb->terminal != cur->terminal && pcb->terminal != KTHREAD_TERMINAL && cur->terminal != KTHREAD_TERMINAL){
+        return vtime_before(fair_vtime[pcb->terminal], fair_vtime[cur->terminal]);
+    }
+    return pcb->priority < cur->priority;
+}
+
+// Function: dl_new_period
+// Description: Starts a deadline process's next period right now
+// Inputs: pcb - the process
+//         now - clock_ns
+// Outputs: None
+static void dl_new_period(pcb_t* pcb, uint64_t now) {
+    pcb->dl_deadline = now + (uint64_t)pcb->dl_period_us * NS_PER_US;
+    pcb->dl_runtime = (int64_t)pcb->dl_budget_us * NS_PER_US;
+}
+
+// Function: dl_ticks_until
+// Description: Finds the first tick at or after a point in time
+// Inputs: when, now - clock_ns values
+// Outputs: ticks from now to then, at least 1
+static uint32_t dl_ticks_until(uint64_t when, uint64_t now) {
+    if(when <= now){
+        return 1;
+    }
+    // periods are at most DL_MAX_PERIOD_US, the quotient is small
+    return div64_32(when - now + NS_PER_TICK - 1, NS_PER_TICK, NULL);
+}
+
+// Function: dl_replenish
+// Description: Gives a throttled deadline process its budget back at its deadline,
+//              with the next period's deadline, an overrun is paid off out of the
+//              new budget
+// Inputs: data - pcb of the process
+// Outputs: None
+// Effects: runs from the tick on CPU 0, queues the process if it is runnable
+static void dl_replenish(uint32_t data) {
+    pcb_t* pcb = (pcb_t*)data;
+    runqueue_t* rq;
+    uint32_t queued = 0, resched = 0;
+    uint64_t now;
+
+    rq = rq_lock_pcb(pcb);
+    if(pcb->dl_period_us == 0 || !pcb->dl_throttled){
+        spin_unlock(&rq->lock);
+        return;
+    }
+    now = clock_ns();
+    pcb->dl_deadline += (uint64_t)pcb->dl_period_us * NS_PER_US;
+    pcb->dl_runtime += (int64_t)pcb->dl_budget_us * NS_PER_US;
+    if(pcb->dl_deadline <= now){
+        // we are late, it starts over from now
+        dl_new_period(pcb, now);
+    } else if(pcb->dl_runtime <= 0){
+        // still in debt, wait for another period
+        pcb->dl_timer.expires = pit_ticks + dl_ticks_until(pcb->dl_deadline, now);
+        timer_add(&pcb->dl_timer);
+        spin_unlock(&rq->lock);
+        return;
+    }
+    pcb->dl_throttled = 0;
+    // one that is still on the CPU just keeps running
+    if(pcb->state == PROC_RUNNABLE && rq->current != pcb){
+        rq_enqueue(rq, pcb);
+        sched_lat_wake(pcb);
+        queued = 1;
+        if(sched_preempts(rq, pcb)){
+            rq->need_resched = resched = 1;
+        }
+    }
+    spin_unlock(&rq->lock);
+    if(queued && nr_cpus > 1){
+        sched_kick(rq, resched);
+    }
+}
+
+// Function: dl_charge
+// Description: Charges a deadline process for the time it ran since rq->dl_start,
+//              and throttles it until its deadline if the budget is used up
+// Inputs: rq - locked run queue of the CPU it runs on
+//         pcb - the process, the one running there
+//         now - clock_ns
+// Outputs: None
+// Effects: budgets are only checked on ticks and switches, an overrun of up to a
+//          tick is taken out of the next period
+static void dl_charge(runqueue_t* rq, pcb_t* pcb, uint64_t now) {
+    pcb->dl_runtime -= (int64_t)(now - rq->dl_start);
+    rq->dl_start = now;
+    if(pcb->dl_runtime > 0 || pcb->dl_throttled){
         return;
     }
+    pcb->dl_throttled = 1;
+    pcb->dl_timer.expires = pit_ticks + dl_ticks_until(pcb->dl_deadline, now);
+    pcb->dl_timer.func = dl_replenish;
+    pcb->dl_timer.data = (uint32_t)pcb;
+    timer_add(&pcb->dl_timer);
+    rq->need_resched = 1;
+}
+
+// Function: dl_wakeup
+// Description: Decides whether a deadline process that wakes up keeps its deadline.
+//              It does only if what is left of its budget, spent before that
+//              deadline, stays within its share of the CPU, otherwise it starts
+//              a new period, so sleeping cannot be used to save up CPU time.
+// Inputs: pcb - the process, blocked or new
+// Outputs: None
+static void dl_wakeup(pcb_t* pcb) {
+    uint64_t now = clock_ns();
+
+    // a throttled one waits for its replenishment
+    if(pcb->dl_throttled){
+        return;
+    }
+    // runtime / (deadline - now) > budget / period, without dividing
+    if(pcb->dl_deadline <= now ||
+       (uint64_t)pcb->dl_runtime * pcb->dl_period_us > (pcb->dl_deadline - now) * pcb->dl_budget_us){
+        dl_new_period(pcb, now);
+    }
+}
+
+// Function: sched_wakeup
+// Description: Makes a process runnable. A process that was blocked moves up
+//              io_boost levels, it used little CPU before it had to wait.
+//              New processes go to the least loaded CPU, kernel threads to CPU 0.
+// Inputs: pcb - new or blocked process
+// Outputs: None
+// Effects: the process preempts the running one at the next tick if it has a higher priority
+void sched_wakeup(pcb_t* pcb) {
+    uint32_t flags;
+    uint32_t queued = 0, resched = 0;
+    runqueue_t* rq;
+
+    cli_and_save(flags);
+    if(pcb->state == PROC_NEW){
+        pcb->cpu = (pcb->terminal == KTHREAD_TERMINAL) ? 0 : sched_pick_cpu();
+    }
+    rq = rq_lock_pcb(pcb);
+    if(pcb->state != PROC_RUNNABLE){
+        if(pcb->dl_period_us != 0){
+            dl_wakeup(pcb);
+        } else if(pcb->terminal != KTHREAD_TERMINAL){
+            if(pcb->state == PROC_BLOCKED){
+                pcb->priority = (pcb->priority > sched_tunables.io_boost) ? pcb->priority - sched_tunables.io_boost : 0;
+                pcb->slice_left = 0;
+            }
+            fair_wakeup(pcb);
+        }
+        pcb->state = PROC_RUNNABLE;
+        // one that blocked but has not switched away yet just keeps running
+        if(rq->current != pcb && !pcb->dl_throttled){
+            rq_enqueue(rq, pcb);
+            sched_lat_wake(pcb);
+            queued = 1;
+            if(sched_preempts(rq, pcb)){
+                rq->need_resched = resched = 1;
+            }
+        }
+    }
+    spin_unlock(&rq->lock);
+    if(queued && nr_cpus > 1){
+        sched_kick(rq, resched);
+    }
+    restore_flags(flags);
+}
+
+// Function: sched_set_tunables
+// Description: Changes the scheduler tunables
+// Inputs: tunables - new values, every quantum and the boost interval must be
+//                    at least one tick, io_boost less than MLFQ_LEVELS and
+//                    every share from 1 to FAIR_MAX_SHARE
+// Outputs: 0, or -1 if a value is out of range
+// Effects: new quanta apply from each process's next time slice, new shares
+//          from the next tick
+int32_t sched_set_tunables(const sched_tunables_t* tunables) {
+    uint32_t flags;
+    int i;
+
+    for(i = 0; i < MLFQ_LEVELS; i++){
+        if(tunables->quantum[i] == 0){
+            return -1;
+        }
+    }
+    for(i = 0; i < FAIR_GROUPS; i++){
+        if(tunables->share[i] == 0 || tunables->share[i] > FAIR_MAX_SHARE){
+            return -1;
+        }
+    }
+    if(tunables->boost_interval == 0 || tunables->io_boost >= MLFQ_LEVELS){
+        return -1;
+    }
+    // fair_charge reads the shares under fair_lock
+    spin_lock_irqsave(&fair_lock, flags);
+    sched_tunables = *tunables;
+    spin_unlock_irqrestore(&fair_lock, flags);
+    return 0;
+}
+
+// Function: sched_fair_get
+// Description: Reports the share of every terminal's group and the CPU time it used
+// Inputs: stats - FAIR_GROUPS entries to fill in, one per terminal
+// Outputs: None
+void sched_fair_get(fair_stat_t* stats) {
+    uint32_t flags;
+    int i;
+
+    spin_lock_irqsave(&fair_lock, flags);
+    for(i = 0; i < FAIR_GROUPS; i++){
+        stats[i].share = sched_tunables.share[i];
+        stats[i].ticks = fair_ticks[i];
+    }
+    spin_unlock_irqrestore(&fair_lock, flags);
+}
 
-    // Get the PCB (Process Control Block) of the current and next process
-    sched_terminal = temp_terminal;
-    new_pid = terminal_array[sched_terminal].terminal_current_pid;
-
-    pcb_t *pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
-    pcb_t *nxt_pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
-
-    // If the next terminal has an active process, switch the paging to its page directory
-    // There are terminals at pid's 0,1,2
-    // Check if there are any none-base shell processes funning
-    if(terminal_array[sched_terminal].terminal_current_pid > 2){
-        nxt_pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (terminal_array[sched_terminal].terminal_current_pid + 1));
-        page_directory[USR_IDX].present = page_directory[USR_IDX].rw = page_directory[USR_IDX].us = page_directory[USR_IDX].ps = page_directory[USR_IDX].g = 1;
-        page_directory[USR_IDX].pwt = page_directory[USR_IDX].pcd = page_directory[USR_IDX].acc = page_directory[USR_IDX].avl = page_directory[USR_IDX].avl_3 = 0;
-        page_directory[USR_IDX].addy = ((uint32_t)(EIGHTMB + (nxt_pcb->pid * FOURMB))) >> SHIFT_12;
-        flush_tlb();
-    }
-    
-    // Set up the video memory paging for the next terminal
-    vid_table[0].present = vid_table[0].rw = vid_table[0].us = 1;
-    if(sched_terminal == current_terminal){
-        vid_table[0].addy = VIDEO_START >> SHIFT_12;
+// Function: schedule
+// Description: Gives this CPU to the next runnable process. A process that is
+//              not runnable anymore only comes back once someone wakes it up.
+//              With nothing of our own to run, we take a process from another CPU.
+// Inputs: None
+// Outputs: None
+// Effects: switches page directory, TSS and kernel stack
+void schedule() {
+    uint32_t flags, id;
+    runqueue_t* rq;
+    cpu_t* cpu;
+    pcb_t *prev, *next;
+    uint64_t now;
+
+    cli_and_save(flags);
+    rq = this_rq();
+    prev = rq->current;
+#if TICKLESS_IDLE
+    // timers that expired while idle may wake someone, so this goes first
+    if(prev == rq->idle && nohz_allowed()){
+        nohz_exit();
+    }
+#endif
+    spin_lock(&rq->lock);
+    id = rq - runqueues;
+    // a process that moved to another CPU is queued there by schedule_tail
+    if(prev->dl_period_us != 0 && prev->cpu == id){
+        dl_charge(rq, prev, clock_ns());
+    }
+    // a preempted process goes to the back of the queue, the idle task is never queued
+    if(prev != rq->idle && prev->state == PROC_RUNNABLE && prev->cpu == id){
+        rq_enqueue(rq, prev);
+    }
+    next = rq_dequeue(rq);
+    if(next == NULL && nr_cpus > 1){
+        next = rq_steal(rq);
+    }
+    if(next == NULL){
+        next = rq->idle;
+    }
+    rq->need_resched = 0;
+    if(next->dl_period_us != 0){
+        rq->dl_start = clock_ns();
+    }
+    // a process that used up its slice starts a new one at its current level
+    if(next->slice_left == 0){
+        next->slice_left = sched_tunables.quantum[next->priority];
+    }
+    if(next == prev){
+        spin_unlock(&rq->lock);
+        restore_flags(flags);
+        return;
+    }
+
+    // the idle task runs on the kernel's page directory
+    cpu = this_cpu();
+    if(next == rq->idle){
+        cpu->pid = -1;
+        load_page_directory(page_directory);
+    } else if(next->terminal == KTHREAD_TERMINAL){
+        cpu->pid = next->pid;
+        // kernel threads never touch user memory, with one CPU they keep the current
+        // mappings, with more the process they belong to may exit somewhere else
+        if(nr_cpus > 1){
+            load_page_directory(page_directory);
+        }
     } else {
-        vid_table[0].addy = (VIDEO_PAGES >> SHIFT_12) + sched_terminal;
+        cpu->pid = next->pid;
+        load_page_directory(next->page_dir);
+
+        // Update the Task State Segment (TSS) for the next process
+        cpu->tss->ss0 = KERNEL_DS;
+        cpu->tss->esp0 = KSTACK_TOP(next);
     }
 
-    // Update the Task State Segment (TSS) for the next process
-    tss.ss0 = KERNEL_DS;
-    // subtract 4 for a memfence for safety
-    tss.esp0 = EIGHTMB - EIGHTKB * new_pid - 4;
+    // account the time slice that just ended
+    now = rdtsc();
+    prev->cpu_stats.cycles += now - rq->switch_tsc;
+    if(prev->state == PROC_RUNNABLE){
+        prev->cpu_stats.nivcsw++;
+    } else {
+        prev->cpu_stats.nvcsw++;
+    }
+    rq->switch_tsc = now;
+    sched_lat_run(prev, next);
 
-    // Save the current process's stack pointer and base pointer
-	asm volatile(
-        "movl   %%ebp, %0   ;"
-        "movl   %%esp, %1   ;"
-        :"=r"(pcb->program_ebp), "=r"(pcb->program_esp)
-    );
+    fpu_switch(prev, next);
+    next->on_cpu = 1;
+    rq->current = next;
+    rq->switched_from = prev;
+    // the run queue stays locked across the switch, schedule_tail unlocks it
+    context_switch(&prev->context_esp, next->context_esp);
+    schedule_tail();
 
-    // Load the next process's stack pointer and base pointer
-    asm volatile(
-        "movl   %0, %%esp   ;"
-        "movl   %1, %%ebp   ;"
-        : :"r"(nxt_pcb->program_esp), "r"(nxt_pcb->program_ebp) 
-    );
+    restore_flags(flags);
+}
 
-    sti();
-    return;
+// Function: sched_move
+// Description: Queues a runnable process that just left this CPU on the CPU it
+//              moved to
+// Inputs: pcb - the process, on no queue and no CPU
+// Outputs: None
+// Effects: interrupts must be off
+static void sched_move(pcb_t* pcb) {
+    runqueue_t* rq = rq_lock_pcb(pcb);
+    uint32_t resched = 0;
+
+    rq_enqueue(rq, pcb);
+    if(sched_preempts(rq, pcb)){
+        rq->need_resched = resched = 1;
+    }
+    spin_unlock(&rq->lock);
+    sched_kick(rq, resched);
+}
+
+// Function: schedule_tail
+// Description: Runs on the new kernel stack right after a switch
+// Inputs: None
+// Outputs: None
+// Effects: unlocks the run queue, the process we switched away from may run on
+//          another CPU from here on, or is freed if it exited without a parent
+void schedule_tail() {
+    runqueue_t* rq = this_rq();
+    pcb_t* prev = rq->switched_from;
+    uint32_t dead = 0, moved = 0;
+
+    if(prev != NULL){
+        dead = (prev->state == PROC_DEAD);
+        moved = (prev != rq->idle && prev->state == PROC_RUNNABLE && prev->cpu != rq - runqueues);
+        prev->on_cpu = 0;
+    }
+    rq->switched_from = NULL;
+    spin_unlock(&rq->lock);
+    if(dead){
+        process_release(prev);
+    }
+    if(moved){
+        sched_move(prev);
+    }
+}
+
+// protects the CPU shares deadline processes reserved, dl_util of every run queue
+static spinlock_t dl_lock = SPINLOCK_INIT;
+
+// Function: sched_set_deadline
+// Description: Makes a process a deadline process, with budget_us of CPU time
+//              every period_us, or a normal one again with a period of 0.
+//              Admission control keeps the budgets on each CPU within
+//              DL_UTIL_MAX of it, which is what EDF can always meet. A process
+//              that does not fit where it runs moves to the CPU with the most
+//              room left that it fits on.
+// Inputs: pcb - the running process, or one that is exiting
+//         period_us - period and relative deadline, at most DL_MAX_PERIOD_US
+//         budget_us - CPU time per period, at least DL_MIN_BUDGET_US and at most period_us
+// Outputs: 0, or -1 if a value is out of range or no CPU has room
+// Effects: the first period starts now, the process switches CPUs before returning
+int32_t sched_set_deadline(pcb_t* pcb, uint32_t period_us, uint32_t budget_us) {
+    uint32_t flags, util = 0, cpu, target, i;
+    runqueue_t* rq;
+
+    if(period_us != 0){
+        if(period_us > DL_MAX_PERIOD_US || budget_us < DL_MIN_BUDGET_US || budget_us > period_us){
+            return -1;
+        }
+        util = div64_32((uint64_t)budget_us << DL_UTIL_SHIFT, period_us, NULL);
+    }
+
+    // running, so it is on no queue and nobody moves it
+    cli_and_save(flags);
+    cpu = pcb->cpu;
+    target = cpu;
+    spin_lock(&dl_lock);
+    if(runqueues[cpu].dl_util - pcb->dl_util + util > DL_UTIL_MAX){
+        target = NR_CPUS;
+        for(i = 0; i < nr_cpus; i++){
+            if(i != cpu && runqueues[i].dl_util + util <= DL_UTIL_MAX &&
+               (target == NR_CPUS || runqueues[i].dl_util < runqueues[target].dl_util)){
+                target = i;
+            }
+        }
+        if(target == NR_CPUS){
+            spin_unlock(&dl_lock);
+            restore_flags(flags);
+            return -1;
+        }
+    }
+    runqueues[cpu].dl_util -= pcb->dl_util;
+    runqueues[target].dl_util += util;
+    pcb->dl_util = util;
+    spin_unlock(&dl_lock);
+
+    // a replenishment for the old values must not come in after the new ones
+    timer_del(&pcb->dl_timer);
+
+    rq = rq_lock_pcb(pcb);
+    pcb->dl_period_us = period_us;
+    pcb->dl_budget_us = budget_us;
+    pcb->dl_throttled = 0;
+    if(period_us != 0){
+        rq->dl_start = clock_ns();
+        dl_new_period(pcb, rq->dl_start);
+    }
+    pcb->cpu = target;
+    spin_unlock(&rq->lock);
+
+    // schedule_tail queues it on the new CPU once this one has let go of it,
+    // no tick may charge it here in between
+    if(target != cpu){
+        schedule();
+    }
+    restore_flags(flags);
+    return 0;
 }
@@ -1,15 +1,143 @@
 #ifndef _SCHEDULE_H
 #define _SCHEDULE_H
 #include "lib.h"
+#include "spinlock.h"
 
 #define COUNT 23862 //  23862 will give us 20ms or 50Hz
 #define CHANNEL_0_DATA_PORT 0x40
 #define COMMAND_REG 0x43
 #define CHANNEL_MODE 0x36 // 0011 0110 selects channel 0 and mode 3 for square wave generator
+#define ONESHOT_MODE 0x30 // 0011 0000 selects channel 0 and mode 0, one interrupt when the count runs out
+#define LATCH_CMD    0x00 // 0000 0000 latches the count of channel 0
+#define READBACK_CMD 0xC2 // 1100 0010 latches the status and count of channel 0
+#define STATUS_OUT   0x80 // output pin bit of the read-back status
+#define MAX_PIT_COUNT 0xFFFF
+
+// set to 0 to keep the PIT ticking while idle, the local APIC timer always keeps going
+#define TICKLESS_IDLE 1
+// ticks the longest one-shot reaches into, the count itself is cut to MAX_PIT_COUNT
+#define NOHZ_MAX_TICKS (MAX_PIT_COUNT / COUNT + 1)
 
 // initializing programmable interval timer
 void PIT_init( void );
+#define RPL_MASK 0x3
+#define USER_RPL 0x3
+
 // handling programmable interval timer interrupts for scheduling
-void pit_handler( void );
+void pit_irq_handler( uint32_t cs );
+// starts the scheduler tick, the local APIC timer or else the PIT
+void tick_init( void );
+// each CPU's own tick when the local APIC timer is used
+void lapic_timer_handler( uint32_t cs );
+// the tick CPU 0 passes on to the others when the PIT is the tick, and requests from other CPUs to reschedule
+void ipi_tick_handler( uint32_t cs );
+void ipi_resched_handler( void );
+
+// number of priority levels, 0 is the highest
+#define MLFQ_LEVELS 4
+// ticks a process may run at each level before it moves down one
+#define MLFQ_DEFAULT_QUANTA {1, 2, 4, 8}
+// ticks between moving every process back to the top level
+#define MLFQ_DEFAULT_BOOST 50
+// levels a process moves up when it wakes up from blocking
+#define MLFQ_DEFAULT_IO_BOOST 1
+
+// every terminal is a group that gets CPU time in proportion to its share,
+// the MLFQ splits it among the group's processes, kernel threads are in no group
+#define FAIR_GROUPS         3   // TERMINAL_COUNT
+#define FAIR_DEFAULT_SHARE  100
+#define FAIR_MAX_SHARE      10000
+// virtual time a group with the default share runs up in one tick, a group
+// with twice the share runs up half as much
+#define FAIR_TICK_VTIME     1024
+// how far the running group may get ahead of one that is waiting before it
+// gives up the CPU, and the head start a group gets when it wakes up
+#define FAIR_GRANULARITY    FAIR_TICK_VTIME
+
+// scheduler settings that can be changed at runtime with schedctl
+typedef struct sched_tunables_t {
+    uint32_t quantum[MLFQ_LEVELS];
+    uint32_t boost_interval;
+    uint32_t io_boost;
+    // CPU share of each terminal's group, relative to the other groups
+    uint32_t share[FAIR_GROUPS];
+} sched_tunables_t;
+
+extern sched_tunables_t sched_tunables;
+
+// checks and installs new tunables, returns 0 or -1 if a value is out of range
+extern int32_t sched_set_tunables(const sched_tunables_t* tunables);
+
+// what kstat(KSTAT_FAIR_SHARE) returns for each terminal's group
+typedef struct fair_stat_t {
+    uint32_t share;
+    // ticks its processes ran, deadline processes not included
+    uint32_t ticks;
+} fair_stat_t;
+
+// copies the share and usage of every group
+extern void sched_fair_get(fair_stat_t* stats);
+
+// deadline processes get a budget of CPU time every period, they run before
+// every other process, earliest deadline first, on the CPU they were admitted to
+#define DL_MIN_BUDGET_US    100
+#define DL_MAX_PERIOD_US    1000000
+// share of a CPU deadline processes may reserve together, the rest is for
+// everyone else, in 1 / 2^DL_UTIL_SHIFT of the CPU
+#define DL_UTIL_SHIFT       20
+#define DL_UTIL_MAX         ((1 << DL_UTIL_SHIFT) / 10 * 9)
+
+// a run queue has one FIFO for every level of every group, queue
+// group * MLFQ_LEVELS + level, group 0 holds the kernel threads and group
+// terminal + 1 the processes of a terminal
+#define RQ_QUEUES           ((FAIR_GROUPS + 1) * MLFQ_LEVELS)
+#define RQ_LEVEL_MASK       ((1 << MLFQ_LEVELS) - 1)
+
+struct pcb_t;
+
+// what each CPU schedules from, a process is on at most one of them
+// lock protects everything in it and the state of the processes queued on it
+typedef struct runqueue_t {
+    spinlock_t lock;
+    // runnable processes that are not on a CPU, see RQ_QUEUES
+    struct pcb_t* head[RQ_QUEUES];
+    struct pcb_t* tail[RQ_QUEUES];
+    // bit i is set while queue i is not empty
+    uint32_t bitmap;
+    // queued processes another CPU may take, kernel threads stay on CPU 0
+    volatile uint32_t nr_movable;
+    // process on the CPU, and the CPU's idle task
+    struct pcb_t* current;
+    struct pcb_t* idle;
+    // process we last switched away from, schedule_tail finishes the switch
+    struct pcb_t* switched_from;
+    // TSC when the running process was switched to
+    uint64_t switch_tsc;
+    // runnable deadline processes that are not throttled, earliest deadline first
+    struct pcb_t* dl_head;
+    // clock_ns when the running deadline process last had its budget charged
+    uint64_t dl_start;
+    // CPU share reserved by the deadline processes admitted here
+    uint32_t dl_util;
+    // set when the running process should give up the CPU at the next chance
+    volatile uint8_t need_resched;
+} runqueue_t;
+
+// turns the boot context into the idle task of CPU 0
+extern void sched_init( void );
+// turns a freshly started CPU's context into its idle task
+extern void sched_init_cpu( void );
+// body of the idle task, the boot context ends up here
+extern void cpu_idle( void );
+// makes a new or blocked process runnable and queues it
+extern void sched_wakeup( struct pcb_t* pcb );
+// makes a process a deadline process, or a normal one again with a period of 0,
+// returns 0 or -1 if the values are out of range or no CPU has room for it
+extern int32_t sched_set_deadline( struct pcb_t* pcb, uint32_t period_us, uint32_t budget_us );
+
+// switches to the next runnable process, returns when we are picked again
+extern void schedule( void );
+// finishes a switch on the new stack, called on the way out of schedule and by new processes
+extern void schedule_tail( void );
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef _SCHEDULE_WRAPPER_H
+#define _SCHEDULE_WRAPPER_H
+
+// what context_switch leaves on a stack it switches away from,
+// from the lowest address up
+#define CONTEXT_EFLAGS  0
+#define CONTEXT_EBX     3
+#define CONTEXT_RET     5
+#define CONTEXT_WORDS   6
+
+#ifndef ASM
+#include "types.h"
+
+// saves the current kernel stack pointer to *save_esp and continues on next_esp
+extern void context_switch(uint32_t* save_esp, uint32_t next_esp);
+
+// return address for the first context_switch into a new process
+extern void process_start();
+
+// return address for the first context_switch into a kernel thread,
+// calls the function in the saved ebx
+extern void kthread_start();
+
+#endif
+#endif
@@ -0,0 +1,250 @@
+// kernel heap built from slab caches
+// every slab is one page from the buddy allocator, carved into equally sized
+// objects, so allocation and free are O(1) list operations
+
+#include "slab.h"
+#include "lib.h"
+
+static kmem_cache_t caches[MAX_CACHES];
+static int32_t num_caches = 0;
+
+// one cache per kmalloc size class
+static kmem_cache_t* kmalloc_caches[KMALLOC_CLASSES];
+
+// first object in a slab page comes right after the header
+#define SLAB_OBJ_OFFSET ((sizeof(slab_t) + KMEM_ALIGN - 1) & ~(KMEM_ALIGN - 1))
+
+// Description: links a slab at the head of a list
+// Inputs: head - list to add to, slab - slab to add
+// Outputs: none
+// Effects: changes *head
+static void slab_list_add(slab_t** head, slab_t* slab){
+    slab->prev = NULL;
+    slab->next = *head;
+    if(*head != NULL){
+        (*head)->prev = slab;
+    }
+    *head = slab;
+}
+
+// Description: unlinks a slab from a list
+// Inputs: head - list the slab is on, slab - slab to remove
+// Outputs: none
+// Effects: changes *head if the slab was first
+static void slab_list_remove(slab_t** head, slab_t* slab){
+    if(slab->prev != NULL){
+        slab->prev->next = slab->next;
+    } else {
+        *head = slab->next;
+    }
+    if(slab->next != NULL){
+        slab->next->prev = slab->prev;
+    }
+    slab->next = slab->prev = NULL;
+}
+
+// Description: adds a fresh slab to a cache
+// Inputs: cache - cache to grow
+// Outputs: the new slab, NULL if there is no memory
+// Effects: takes a page from the buddy allocator
+static slab_t* slab_grow(kmem_cache_t* cache){
+    slab_t* slab = (slab_t*)alloc_pages(ORDER_4KB);
+    if(slab == NULL){
+        return NULL;
+    }
+    slab->magic = SLAB_MAGIC;
+    slab->cache = cache;
+    slab->in_use = 0;
+
+    // thread the free list through the objects
+    uint32_t i;
+    uint8_t* obj = (uint8_t*)slab + SLAB_OBJ_OFFSET;
+    slab->free_list = obj;
+    for(i = 0; i < cache->objs_per_slab - 1; i++, obj += cache->obj_size){
+        *(void**)obj = obj + cache->obj_size;
+    }
+    *(void**)obj = NULL;
+
+    slab_list_add(&cache->partial, slab);
+    cache->slabs++;
+    cache->empty_slabs++;
+    return slab;
+}
+
+// Description: takes one object from a cache
+// Inputs: cache - cache to allocate from, size - bytes the caller asked for
+// Outputs: pointer to the object, NULL if there is no memory
+// Effects: may grow the cache
+static void* cache_alloc(kmem_cache_t* cache, uint32_t size){
+    uint32_t flags;
+    spin_lock_irqsave(&cache->lock, flags);
+
+    slab_t* slab = cache->partial;
+    if(slab == NULL && (slab = slab_grow(cache)) == NULL){
+        spin_unlock_irqrestore(&cache->lock, flags);
+        return NULL;
+    }
+
+    void* obj = slab->free_list;
+    slab->free_list = *(void**)obj;
+    if(slab->in_use == 0){
+        cache->empty_slabs--;
+    }
+    slab->in_use++;
+    if(slab->in_use == cache->objs_per_slab){
+        slab_list_remove(&cache->partial, slab);
+        slab_list_add(&cache->full, slab);
+    }
+
+    cache->active_objs++;
+    cache->allocs++;
+    cache->bytes_requested += size;
+    spin_unlock_irqrestore(&cache->lock, flags);
+    return obj;
+}
+
+// Description: creates the kmalloc size classes
+// Inputs: none
+// Outputs: none
+// Effects: must run after paging is on, slab pages are written through the direct map
+void kmem_init(){
+    int32_t i;
+    int8_t name[CACHE_NAME_LEN];
+    int8_t num[CACHE_NAME_LEN];
+    for(i = 0; i < KMALLOC_CLASSES; i++){
+        strcpy(name, (int8_t*)"kmalloc-");
+        itoa(1 << (i + KMALLOC_MIN_SHIFT), num, 10);
+        strncpy(name + strlen(name), num, CACHE_NAME_LEN - strlen(name) - 1);
+        kmalloc_caches[i] = kmem_cache_create(name, 1 << (i + KMALLOC_MIN_SHIFT));
+    }
+}
+
+// Description: creates a cache for objects of one size
+// Inputs: name - shown in the statistics, size - size of each object
+// Outputs: the cache, NULL if the object does not fit in a page or there are too many caches
+// Effects: none, slabs are only allocated on first use
+kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t size){
+    uint32_t obj_size = (size + KMEM_ALIGN - 1) & ~(KMEM_ALIGN - 1);
+    if(num_caches >= MAX_CACHES || size == 0 || obj_size > PAGE_SIZE - SLAB_OBJ_OFFSET){
+        return NULL;
+    }
+
+    kmem_cache_t* cache = &caches[num_caches++];
+    memset(cache, 0, sizeof(kmem_cache_t));
+    strncpy(cache->name, name, CACHE_NAME_LEN - 1);
+    cache->obj_size = obj_size;
+    cache->objs_per_slab = (PAGE_SIZE - SLAB_OBJ_OFFSET) / obj_size;
+    return cache;
+}
+
+// Description: allocates one object from a cache
+// Inputs: cache - cache to allocate from
+// Outputs: pointer to the object, NULL if there is no memory
+// Effects: may grow the cache
+void* kmem_cache_alloc(kmem_cache_t* cache){
+    return cache_alloc(cache, cache->obj_size);
+}
+
+// Description: returns an object to its cache
+// Inputs: cache - cache the object came from, obj - object to free
+// Outputs: none
+// Effects: releases the slab page if it is empty and the cache already has an empty slab
+void kmem_cache_free(kmem_cache_t* cache, void* obj){
+    slab_t* slab = (slab_t*)((uint32_t)obj & ~(PAGE_SIZE - 1));
+    uint32_t flags;
+
+    if(obj == NULL || slab->magic != SLAB_MAGIC || slab->cache != cache){
+        return;
+    }
+
+    spin_lock_irqsave(&cache->lock, flags);
+    if(slab->in_use == cache->objs_per_slab){
+        slab_list_remove(&cache->full, slab);
+        slab_list_add(&cache->partial, slab);
+    }
+    *(void**)obj = slab->free_list;
+    slab->free_list = obj;
+    slab->in_use--;
+    cache->active_objs--;
+    cache->frees++;
+
+    if(slab->in_use == 0){
+        if(cache->empty_slabs > 0){
+            // keep one empty slab around so we don't bounce pages back and forth
+            slab_list_remove(&cache->partial, slab);
+            slab->magic = 0;
+            free_pages((uint32_t)slab, ORDER_4KB);
+            cache->slabs--;
+        } else {
+            cache->empty_slabs++;
+        }
+    }
+    spin_unlock_irqrestore(&cache->lock, flags);
+}
+
+// Description: general purpose allocation
+// Inputs: size - bytes needed
+// Outputs: pointer to at least size bytes, NULL on failure
+// Effects: sizes above KMALLOC_MAX get whole pages from the buddy allocator
+void* kmalloc(uint32_t size){
+    uint32_t shift;
+    if(size == 0){
+        return NULL;
+    }
+
+    if(size > KMALLOC_MAX){
+        uint32_t order = 0;
+        while((PAGE_SIZE << order) < size){
+            order++;
+        }
+        return (void*)alloc_pages(order);
+    }
+
+    for(shift = KMALLOC_MIN_SHIFT; (1 << shift) < size; shift++);
+    return cache_alloc(kmalloc_caches[shift - KMALLOC_MIN_SHIFT], size);
+}
+
+// Description: frees memory from kmalloc
+// Inputs: ptr - pointer returned by kmalloc
+// Outputs: none
+// Effects: slab objects never start on a page boundary, so anything that
+//          does came from the buddy allocator
+void kfree(void* ptr){
+    int32_t order;
+    if(ptr == NULL){
+        return;
+    }
+    if(((uint32_t)ptr & (PAGE_SIZE - 1)) == 0){
+        // a page aligned pointer that is not the start of a buddy block was
+        // never handed out by kmalloc, so leave it alone
+        order = buddy_block_order((uint32_t)ptr);
+        if(order >= 0){
+            free_pages((uint32_t)ptr, order);
+        }
+        return;
+    }
+    slab_t* slab = (slab_t*)((uint32_t)ptr & ~(PAGE_SIZE - 1));
+    kmem_cache_free(slab->cache, ptr);
+}
+
+// Description: reports usage and fragmentation of every cache
+// Inputs: stats - array to fill, count - number of entries in stats
+// Outputs: number of entries written
+// Effects: none
+int32_t kmem_get_stats(kmem_stat_t* stats, int32_t count){
+    int32_t i;
+    for(i = 0; i < num_caches && i < count; i++){
+        kmem_cache_t* cache = &caches[i];
+        memcpy(stats[i].name, cache->name, CACHE_NAME_LEN);
+        stats[i].obj_size = cache->obj_size;
+        stats[i].objs_per_slab = cache->objs_per_slab;
+        stats[i].slabs = cache->slabs;
+        stats[i].active_objs = cache->active_objs;
+        stats[i].total_objs = cache->slabs * cache->objs_per_slab;
+        stats[i].allocs = cache->allocs;
+        stats[i].frees = cache->frees;
+        stats[i].bytes_requested = cache->bytes_requested;
+        stats[i].slab_waste = PAGE_SIZE - cache->objs_per_slab * cache->obj_size;
+    }
+    return i;
+}
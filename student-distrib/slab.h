@@ -0,0 +1,90 @@
+// kernel heap header file
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include "types.h"
+#include "buddy.h"
+#include "spinlock.h"
+
+#define MAX_CACHES      16
+#define CACHE_NAME_LEN  16
+// every object is at least this aligned (fxsave areas need 16)
+#define KMEM_ALIGN      16
+#define SLAB_MAGIC      0x51AB51AB
+
+// kmalloc size classes are powers of two from KMALLOC_MIN to KMALLOC_MAX
+// anything bigger goes straight to the buddy allocator
+#define KMALLOC_MIN_SHIFT 4
+#define KMALLOC_MAX_SHIFT 10
+#define KMALLOC_MIN     (1 << KMALLOC_MIN_SHIFT)
+#define KMALLOC_MAX     (1 << KMALLOC_MAX_SHIFT)
+#define KMALLOC_CLASSES (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1)
+
+struct kmem_cache_t;
+
+// header at the start of every slab page, the objects follow it
+typedef struct slab_t {
+    uint32_t magic;
+    struct kmem_cache_t* cache;
+    struct slab_t* next;
+    struct slab_t* prev;
+    void* free_list;
+    uint32_t in_use;
+} slab_t;
+
+// a cache of equally sized objects
+// partial holds every slab with at least one free object, full the rest
+// at most one completely empty slab is kept around, the others are freed
+typedef struct kmem_cache_t {
+    // protects the slab lists and the statistics
+    spinlock_t lock;
+    int8_t name[CACHE_NAME_LEN];
+    uint32_t obj_size;
+    uint32_t objs_per_slab;
+    slab_t* partial;
+    slab_t* full;
+    uint32_t empty_slabs;
+
+    // statistics
+    uint32_t slabs;
+    uint32_t active_objs;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t bytes_requested;
+} kmem_cache_t;
+
+// usage and fragmentation numbers for one cache, as returned by kstat
+// total_objs - active_objs slots are allocated but unused,
+// bytes_requested / allocs compared to obj_size is the internal fragmentation
+// and slab_waste is what each slab loses to its header and tail
+typedef struct kmem_stat_t {
+    int8_t name[CACHE_NAME_LEN];
+    uint32_t obj_size;
+    uint32_t objs_per_slab;
+    uint32_t slabs;
+    uint32_t active_objs;
+    uint32_t total_objs;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t bytes_requested;
+    uint32_t slab_waste;
+} kmem_stat_t;
+
+// sets up the kmalloc size classes
+extern void kmem_init();
+
+// creates a cache for objects of a single type
+extern kmem_cache_t* kmem_cache_create(const int8_t* name, uint32_t size);
+
+// O(1) allocation and free of one object from a cache
+extern void* kmem_cache_alloc(kmem_cache_t* cache);
+extern void kmem_cache_free(kmem_cache_t* cache, void* obj);
+
+// general purpose allocation, returns NULL when out of memory
+extern void* kmalloc(uint32_t size);
+extern void kfree(void* ptr);
+
+// fills stats with up to count caches, returns how many were written
+extern int32_t kmem_get_stats(kmem_stat_t* stats, int32_t count);
+
+#endif /* _SLAB_H */
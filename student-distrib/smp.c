@@ -0,0 +1,329 @@
+// multiprocessor support
+// the BIOS lists the CPUs in the MP configuration table, the boot CPU wakes
+// each of the others with INIT and startup IPIs through its local APIC and
+// they join the scheduler with an idle task and a run queue of their own
+
+#include "smp.h"
+#include "lapic.h"
+#include "ioapic.h"
+#include "lib.h"
+#include "paging.h"
+#include "systemcall.h"
+#include "spinlock.h"
+
+// the boot CPU is there from the start, with no process running on it
+cpu_t cpus[NR_CPUS] = {
+    { .id = 0, .online = 1, .pid = -1, .tss = &tss }
+};
+uint32_t nr_cpus = 1;
+
+// TSS of every CPU but the first, which uses tss
+static tss_t ap_tss[NR_CPUS - 1];
+
+// the trampoline in ap_boot.S, copied to AP_TRAMPOLINE
+extern uint8_t ap_trampoline[];
+extern uint8_t ap_trampoline_end[];
+extern uint8_t ap_gdt_desc[];
+// top of the stack the starting CPU runs ap_main on
+extern uint32_t ap_boot_stack;
+
+// CPU that is starting up, it has no TSS yet to find itself with
+static volatile uint32_t ap_booting;
+
+// page the other CPUs drop from their TLB on IPI_TLB_VECTOR
+static volatile uint32_t shootdown_addr;
+// bit i is set until CPU i has dropped shootdown_addr
+static volatile uint32_t shootdown_pending;
+// one shootdown at a time, shootdown_addr stays put until every CPU is done with it
+static spinlock_t shootdown_lock = SPINLOCK_INIT;
+
+// Description: waits a while
+// Inputs: us - about how many microseconds
+// Outputs: none
+// Effects: the PIT may not be running yet, an out to port 0x80 takes about a microsecond
+static void io_delay(uint32_t us){
+    while(us-- > 0){
+        outb(0, IO_DELAY_PORT);
+    }
+}
+
+// Description: maps or unmaps the first MB apart from the pages that are always there
+// Inputs: map - nonzero to map it
+// Outputs: none
+// Effects: the BIOS tables and the trampoline page are only reachable in between
+static void low_mem_map(uint32_t map){
+    uint32_t i;
+
+    for(i = 0; i < LOW_MEM_END >> SHIFT_12; i++){
+        // video memory is mapped for good, and global
+        if(!page_table[i].g){
+            page_table[i].present = map;
+        }
+    }
+    flush_tlb();
+}
+
+// Description: adds up the bytes of a BIOS table
+// Inputs: addr - start of the table, len - its length
+// Outputs: 0 if the checksum is right
+static uint8_t mp_checksum(uint32_t addr, uint32_t len){
+    uint8_t sum = 0;
+    while(len-- > 0){
+        sum += *(uint8_t*)addr++;
+    }
+    return sum;
+}
+
+// Description: looks for the MP floating pointer in one range
+// Inputs: start, len - range to scan
+// Outputs: the floating pointer, NULL if it is not there
+static mp_float_t* mp_scan(uint32_t start, uint32_t len){
+    uint32_t addr;
+
+    for(addr = start; addr + sizeof(mp_float_t) <= start + len; addr += MP_SCAN_ALIGN){
+        if(*(uint32_t*)addr == MP_FLOAT_SIG && mp_checksum(addr, sizeof(mp_float_t)) == 0){
+            return (mp_float_t*)addr;
+        }
+    }
+    return NULL;
+}
+
+// Description: finds the MP configuration table where the spec says it can be
+// Inputs: none
+// Outputs: the table, NULL if there is none we can use
+// Effects: the first MB must be mapped
+static mp_config_t* mp_find_config(){
+    mp_float_t* mpf;
+    mp_config_t* config;
+    uint32_t ebda = (uint32_t)(*(uint16_t*)EBDA_SEG_PTR) << 4;
+
+    mpf = NULL;
+    if(ebda != 0){
+        mpf = mp_scan(ebda, KB);
+    }
+    if(mpf == NULL){
+        mpf = mp_scan(BASE_MEM_LAST_KB, KB);
+    }
+    if(mpf == NULL){
+        mpf = mp_scan(BIOS_ROM_START, BIOS_ROM_END - BIOS_ROM_START);
+    }
+    // a table of one of the default configurations, or one we cannot reach
+    if(mpf == NULL || mpf->config == 0 || mpf->config >= LOW_MEM_END){
+        return NULL;
+    }
+    config = (mp_config_t*)mpf->config;
+    if(config->signature != MP_CONFIG_SIG || config->length > LOW_MEM_END - mpf->config ||
+       mp_checksum(mpf->config, config->length) != 0){
+        return NULL;
+    }
+    return config;
+}
+
+// Description: fills in a TSS descriptor the way entry() does for the first one
+// Inputs: desc - GDT entry, t - the TSS
+// Outputs: none
+static void set_tss_desc(seg_desc_t* desc, tss_t* t){
+    seg_desc_t the_tss_desc;
+
+    the_tss_desc.granularity   = 0x0;
+    the_tss_desc.opsize        = 0x0;
+    the_tss_desc.reserved      = 0x0;
+    the_tss_desc.avail         = 0x0;
+    the_tss_desc.seg_lim_19_16 = TSS_SIZE & 0x000F0000;
+    the_tss_desc.present       = 0x1;
+    the_tss_desc.dpl           = 0x0;
+    the_tss_desc.sys           = 0x0;
+    the_tss_desc.type          = 0x9;
+    the_tss_desc.seg_lim_15_00 = TSS_SIZE & 0x0000FFFF;
+
+    SET_TSS_PARAMS(the_tss_desc, t, TSS_SIZE - 1);
+    *desc = the_tss_desc;
+}
+
+// Description: starts one CPU and waits for it to come up
+// Inputs: cpu - CPU to start, with its id and apic_id set
+// Outputs: 0, or -1 if it did not come up
+// Effects: the trampoline must be in place
+static int32_t smp_boot_ap(cpu_t* cpu){
+    uint32_t stack = alloc_pages(KSTACK_ORDER);
+    uint32_t us;
+
+    if(stack == 0){
+        return -1;
+    }
+    ap_boot_stack = stack + KSTACK_SIZE;
+    ap_booting = cpu->id;
+
+    // INIT, then two startup IPIs as the MP spec asks, the vector is the page to start at
+    lapic_send_ipi(cpu->apic_id, LAPIC_DM_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+    io_delay(AP_INIT_DELAY);
+    lapic_send_ipi(cpu->apic_id, LAPIC_DM_STARTUP | (AP_TRAMPOLINE >> SHIFT_12));
+    io_delay(AP_SIPI_DELAY);
+    if(!cpu->online){
+        lapic_send_ipi(cpu->apic_id, LAPIC_DM_STARTUP | (AP_TRAMPOLINE >> SHIFT_12));
+    }
+    for(us = 0; us < AP_START_TIMEOUT && !cpu->online; us++){
+        io_delay(1);
+    }
+    if(!cpu->online){
+        free_pages(stack, KSTACK_ORDER);
+        return -1;
+    }
+    return 0;
+}
+
+// Description: finds the other CPUs in the MP table and starts them
+// Inputs: none
+// Outputs: none
+// Effects: with a table, the I/O APIC takes the device interrupts and the local
+//          APIC timer is calibrated even if there is a single CPU, without
+//          one everything stays on the 8259 and the PIT
+void smp_init(void){
+    mp_config_t* config;
+    mp_processor_t* proc;
+    uint8_t apic_ids[NR_CPUS];
+    uint32_t lapic_phys, entry, i, n = 1;
+
+    low_mem_map(1);
+    config = mp_find_config();
+    if(config == NULL){
+        low_mem_map(0);
+        return;
+    }
+    lapic_phys = config->lapic_addr ? config->lapic_addr : LAPIC_DEFAULT_PHYS;
+
+    // the boot CPU's own entry is skipped, it is already cpus[0]
+    entry = (uint32_t)config + sizeof(mp_config_t);
+    for(i = 0; i < config->entry_count; i++){
+        proc = (mp_processor_t*)entry;
+        if(proc->type != MP_ENTRY_PROCESSOR){
+            entry += MP_OTHER_SIZE;
+            continue;
+        }
+        entry += MP_PROCESSOR_SIZE;
+        if(!(proc->flags & MP_CPU_BSP) && (proc->flags & MP_CPU_ENABLED) && n < NR_CPUS){
+            apic_ids[n++] = proc->apic_id;
+        }
+    }
+
+    lapic_map(lapic_phys);
+    cpus[0].apic_id = lapic_id();
+    ioapic_init(config);
+    lapic_init(1);
+    lapic_timer_calibrate(COUNT);
+    if(n == 1){
+        low_mem_map(0);
+        return;
+    }
+
+    // the trampoline loads the kernel's GDT before it can reach the kernel
+    memcpy((void*)AP_TRAMPOLINE, ap_trampoline, ap_trampoline_end - ap_trampoline);
+    memcpy((void*)(AP_TRAMPOLINE + (ap_gdt_desc - ap_trampoline)), &gdt_desc, GDT_DESC_SIZE);
+
+    // ids stay dense, a CPU that does not come up gives its slot to the next one
+    for(i = 1; i < n; i++){
+        cpus[nr_cpus].id = nr_cpus;
+        cpus[nr_cpus].apic_id = apic_ids[i];
+        cpus[nr_cpus].pid = -1;
+        cpus[nr_cpus].tss = &ap_tss[nr_cpus - 1];
+        if(smp_boot_ap(&cpus[nr_cpus]) == 0){
+            nr_cpus++;
+        }
+    }
+    low_mem_map(0);
+}
+
+// Description: first C code of a freshly started CPU
+// Inputs: none
+// Outputs: none
+// Effects: never returns, the CPU becomes idle and starts taking processes
+void ap_main(void){
+    cpu_t* cpu = &cpus[ap_booting];
+    tss_t* t = cpu->tss;
+
+    lidt(idt_desc_ptr);
+    lldt(KERNEL_LDT);
+
+    // once the task register points at our own TSS, this_cpu() finds us
+    memset(t, 0, sizeof(tss_t));
+    t->ldt_segment_selector = KERNEL_LDT;
+    t->ss0 = KERNEL_DS;
+    t->esp0 = ap_boot_stack;
+    set_tss_desc(&ap_tss_desc_ptr[cpu->id - 1], t);
+    ltr(AP_TSS + ((cpu->id - 1) << 3));
+
+    fpu_cpu_init();
+    lapic_init(0);
+    sched_init_cpu();
+    // each CPU gets its own tick, unless everyone lives off the PIT's
+    if(lapic_timer_count != 0){
+        lapic_timer_start();
+    }
+    cpu->online = 1;
+    cpu_idle();
+}
+
+// Description: pid of the process running on this CPU
+// Inputs: none
+// Outputs: its pid, -1 while the CPU is idle
+// Effects: interrupts are off while we look, so we cannot move CPUs in between
+int32_t this_pid(void){
+    uint32_t flags;
+    int32_t pid;
+
+    cli_and_save(flags);
+    pid = this_cpu()->pid;
+    restore_flags(flags);
+    return pid;
+}
+
+// Description: drops the page of the shootdown in progress from this CPU's TLB,
+//              unless it already did
+// Inputs: none
+// Outputs: none
+// Effects: interrupts must be off
+static void tlb_shootdown_ack(void){
+    uint32_t id = this_cpu()->id;
+
+    if(shootdown_pending & (1 << id)){
+        asm volatile("invlpg (%0)" : : "r"(shootdown_addr) : "memory");
+        asm volatile("lock btrl %1, %0" : "+m"(shootdown_pending) : "r"(id) : "memory", "cc");
+    }
+}
+
+// Description: makes every other CPU drop a page from its TLB
+// Inputs: vaddr - page whose mapping changed
+// Outputs: none
+// Effects: returns once all of them have, the caller's own TLB is its own business.
+//          The caller must not hold a lock others may spin on with interrupts off,
+//          they could not take the interrupt.
+void tlb_shootdown(uint32_t vaddr){
+    uint32_t flags;
+
+    if(nr_cpus == 1){
+        return;
+    }
+    cli_and_save(flags);
+    // whoever holds the lock waits for us, so we answer while we wait for it
+    while(!spin_trylock(&shootdown_lock)){
+        tlb_shootdown_ack();
+        asm volatile("pause" : : : "memory");
+    }
+    shootdown_addr = vaddr;
+    shootdown_pending = ((1 << nr_cpus) - 1) & ~(1 << this_cpu()->id);
+    lapic_broadcast_ipi(LAPIC_DM_FIXED | IPI_TLB_VECTOR);
+    while(shootdown_pending != 0){
+        asm volatile("pause" : : : "memory");
+    }
+    spin_unlock(&shootdown_lock);
+    restore_flags(flags);
+}
+
+// Description: handles IPI_TLB_VECTOR
+// Inputs: none
+// Outputs: none
+// Effects: invalidates the page tlb_shootdown asked for and tells it we did
+void ipi_tlb_handler(void){
+    tlb_shootdown_ack();
+    lapic_eoi();
+}
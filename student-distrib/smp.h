@@ -0,0 +1,126 @@
+// multiprocessor support header file
+#ifndef _SMP_H
+#define _SMP_H
+
+#include "types.h"
+#include "x86_desc.h"
+
+// the MP floating pointer is found by scanning for this, "_MP_"
+#define MP_FLOAT_SIG    0x5F504D5F
+// and points at a configuration table starting with "PCMP"
+#define MP_CONFIG_SIG   0x504D4350
+
+// where the BIOS may have put the floating pointer
+#define EBDA_SEG_PTR    0x40E
+#define BASE_MEM_LAST_KB 0x9FC00
+#define BIOS_ROM_START  0xF0000
+#define BIOS_ROM_END    0x100000
+#define MP_SCAN_ALIGN   16
+#define KB              1024
+// the first MB is only mapped while we look for the tables and start the other CPUs
+#define LOW_MEM_END     0x100000
+
+// configuration table entries
+#define MP_ENTRY_PROCESSOR  0
+#define MP_PROCESSOR_SIZE   20
+#define MP_OTHER_SIZE       8
+#define MP_CPU_ENABLED      0x01
+#define MP_CPU_BSP          0x02
+
+// the other CPUs start in real mode at this page, it must be below 1MB
+#define AP_TRAMPOLINE       0x8000
+// microseconds to wait after INIT, after each SIPI, and for a CPU to come up
+#define AP_INIT_DELAY       10000
+#define AP_SIPI_DELAY       200
+#define AP_START_TIMEOUT    100000
+// an out to this port takes about a microsecond
+#define IO_DELAY_PORT       0x80
+// bytes lgdt reads, limit and base
+#define GDT_DESC_SIZE       6
+
+typedef struct __attribute__((packed)) mp_float_t {
+    uint32_t signature;
+    uint32_t config;
+    uint8_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    uint8_t features[5];
+} mp_float_t;
+
+typedef struct __attribute__((packed)) mp_config_t {
+    uint32_t signature;
+    uint16_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    uint8_t oem_id[8];
+    uint8_t product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t entry_count;
+    uint32_t lapic_addr;
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+} mp_config_t;
+
+typedef struct __attribute__((packed)) mp_processor_t {
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t apic_version;
+    uint8_t flags;
+    uint32_t signature;
+    uint32_t features;
+    uint32_t reserved[2];
+} mp_processor_t;
+
+struct pcb_t;
+
+// what each CPU keeps for itself
+typedef struct cpu_t {
+    // index into cpus, CPU 0 is the one we booted on
+    uint32_t id;
+    uint32_t apic_id;
+    // set by the CPU itself once it can run processes
+    volatile uint32_t online;
+    // pid of the process running here, -1 while the CPU is idle
+    int32_t pid;
+    // process whose FPU state is in this CPU's registers, NULL if nobody's is
+    struct pcb_t* fpu_owner;
+    tss_t* tss;
+} cpu_t;
+
+extern cpu_t cpus[NR_CPUS];
+// CPUs that are running, they are cpus[0] to cpus[nr_cpus - 1]
+extern uint32_t nr_cpus;
+
+// Description: finds the CPU we are running on from the task register,
+//              every CPU loads its own TSS
+// Inputs: none
+// Outputs: the calling CPU
+// Effects: only stable while interrupts are off, a process can move to
+//          another CPU whenever it is preempted
+static inline cpu_t* this_cpu(void){
+    uint16_t tr;
+    asm volatile("str %0" : "=r"(tr));
+    if(tr < AP_TSS){
+        return &cpus[0];
+    }
+    return &cpus[((tr - AP_TSS) >> 3) + 1];
+}
+
+// pid of the process running on this CPU, -1 if it is idle
+extern int32_t this_pid(void);
+
+// finds the other CPUs and starts them, they end up in their idle task
+extern void smp_init(void);
+
+// called by the trampoline on a freshly started CPU
+extern void ap_main(void);
+
+// drops a page from the TLB of every other CPU and waits until they all have
+extern void tlb_shootdown(uint32_t vaddr);
+
+// interrupt handlers of the local APIC vectors
+extern void ipi_tlb_handler(void);
+
+#endif /* _SMP_H */
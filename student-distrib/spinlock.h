@@ -0,0 +1,112 @@
+// spinlock header file
+// on more than one CPU turning interrupts off only protects against this
+// CPU, data other CPUs touch too needs one of these as well
+#ifndef _SPINLOCK_H
+#define _SPINLOCK_H
+
+#include "types.h"
+
+typedef struct spinlock_t {
+    volatile uint32_t locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT { 0 }
+
+// Description: sets up an unlocked lock
+// Inputs: lock - lock to set up
+// Outputs: none
+static inline void spin_init(spinlock_t* lock){
+    lock->locked = 0;
+}
+
+// Description: takes the lock if it is free
+// Inputs: lock - lock to take
+// Outputs: nonzero if we got it
+// Effects: xchg is atomic and a full barrier
+static inline int32_t spin_trylock(spinlock_t* lock){
+    uint32_t old = 1;
+    asm volatile("xchgl %0, %1" : "+r"(old), "+m"(lock->locked) : : "memory");
+    return old == 0;
+}
+
+// Description: waits until the lock is free and takes it
+// Inputs: lock - lock to take
+// Outputs: none
+// Effects: interrupts must be off if an interrupt handler takes the lock too
+static inline void spin_lock(spinlock_t* lock){
+    while(!spin_trylock(lock)){
+        // only read while it is held, so the cache line is not bounced around
+        while(lock->locked){
+            asm volatile("pause" : : : "memory");
+        }
+    }
+}
+
+// Description: releases the lock
+// Inputs: lock - lock we hold
+// Outputs: none
+// Effects: stores are not reordered with older stores on x86, a compiler barrier is enough
+static inline void spin_unlock(spinlock_t* lock){
+    asm volatile("" : : : "memory");
+    lock->locked = 0;
+}
+
+// Description: adds one to a counter other CPUs may be changing too
+// Inputs: counter - counter to increment
+// Outputs: none
+// Effects: the lock prefix makes the read-modify-write atomic
+static inline void atomic_inc(volatile uint32_t* counter){
+    asm volatile("lock incl %0" : "+m"(*counter) : : "memory", "cc");
+}
+
+// Description: raises a maximum other CPUs may be raising too
+// Inputs: max - maximum to update
+//         value - new sample
+// Outputs: none
+// Effects: retries the compare-exchange until max is at least value
+static inline void atomic_max(volatile uint32_t* max, uint32_t value){
+    uint32_t old = *max;
+    uint32_t seen;
+
+    while(value > old){
+        asm volatile("lock cmpxchgl %2, %1"
+                     : "=a"(seen), "+m"(*max)
+                     : "r"(value), "0"(old)
+                     : "memory", "cc");
+        if(seen == old){
+            return;
+        }
+        old = seen;
+    }
+}
+
+// turns interrupts off, then takes the lock
+#define spin_lock_irqsave(lock, flags)  \
+do {                                    \
+    asm volatile ("                   \n\
+            pushfl                    \n\
+            popl %0                   \n\
+            cli                       \n\
+            "                           \
+            : "=r"(flags)               \
+            :                           \
+            : "memory", "cc"            \
+    );                                  \
+    spin_lock(lock);                    \
+} while (0)
+
+// releases the lock, then restores the interrupt flag
+#define spin_unlock_irqrestore(lock, flags) \
+do {                                    \
+    spin_unlock(lock);                  \
+    asm volatile ("                   \n\
+            pushl %0                  \n\
+            popfl                     \n\
+            "                           \
+            :                           \
+            : "r"(flags)                \
+            : "memory", "cc"            \
+    );                                  \
+} while (0)
+
+#endif /* _SPINLOCK_H */
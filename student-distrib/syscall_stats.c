@@ -0,0 +1,68 @@
+// per system call counters and latency histograms
+// systemcall_wrapper timestamps every call with rdtsc and reports here
+
+#include "syscall_stats.h"
+#include "systemcall.h"
+#include "spinlock.h"
+
+syscall_stats_t global_syscall_stats;
+
+// Description: finds the histogram bucket for a latency
+// Inputs: cycles - latency of one call in TSC cycles
+// Outputs: index of the highest set bit, 0 for a zero latency
+// Effects: none
+uint32_t syscall_stats_bucket(uint32_t cycles){
+    uint32_t bucket;
+    if(cycles == 0){
+        return 0;
+    }
+    asm volatile("bsrl %1, %0" : "=r"(bucket) : "rm"(cycles));
+    return bucket;
+}
+
+// Description: counts one call to a system call
+// Inputs: index - system call number - 1
+// Outputs: none
+// Effects: increments the global and the current process's call counters
+void syscall_stats_enter(uint32_t index){
+    if(index >= NUM_SYSCALLS){
+        return;
+    }
+    // every CPU counts into the global set
+    atomic_inc(&global_syscall_stats.calls[index]);
+    pcb_t* pcb = current_pcb();
+    if(pcb != NULL){
+        pcb->syscall_stats.calls[index]++;
+    }
+}
+
+// Description: records how long a system call took
+// Inputs: index - system call number - 1
+//         start_lo, start_hi - TSC value read when the call was entered
+// Outputs: none
+// Effects: adds the latency to the global and the current process's histograms
+//          execute is charged for the whole lifetime of the child it started
+void syscall_stats_exit(uint32_t index, uint32_t start_lo, uint32_t start_hi){
+    if(index >= NUM_SYSCALLS){
+        return;
+    }
+    uint64_t start = ((uint64_t)start_hi << 32) | start_lo;
+    uint64_t delta = rdtsc() - start;
+
+    // anything that does not fit in 32 bits lands in the last bucket
+    uint32_t bucket = (delta >> 32) ? SYSSTAT_BUCKETS - 1 : syscall_stats_bucket((uint32_t)delta);
+
+    atomic_inc(&global_syscall_stats.hist[index][bucket]);
+    pcb_t* pcb = current_pcb();
+    if(pcb != NULL){
+        pcb->syscall_stats.hist[index][bucket]++;
+    }
+}
+
+// Description: clears a set of statistics
+// Inputs: stats - statistics to clear
+// Outputs: none
+// Effects: zeroes every counter in stats
+void syscall_stats_reset(syscall_stats_t* stats){
+    memset(stats, 0, sizeof(syscall_stats_t));
+}
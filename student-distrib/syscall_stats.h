@@ -0,0 +1,37 @@
+// system call statistics header file
+#ifndef _SYSCALL_STATS_H
+#define _SYSCALL_STATS_H
+
+#include "types.h"
+#include "systemcall_wrapper.h"
+
+// one histogram bucket per power of two of the 32-bit cycle count
+#define SYSSTAT_BUCKETS 32
+// pid passed to sysstat to read the system-wide numbers
+#define SYSSTAT_GLOBAL -1
+
+// call counts and log2 latency histograms for every system call
+// both arrays are indexed by (system call number - 1), just like the jump table
+// bucket i of a histogram counts calls that took [2^i, 2^(i+1)) TSC cycles
+// calls that never return (halt) are counted but have no latency sample
+typedef struct syscall_stats_t {
+    uint32_t calls[NUM_SYSCALLS];
+    uint32_t hist[NUM_SYSCALLS][SYSSTAT_BUCKETS];
+} syscall_stats_t;
+
+// statistics for every process combined
+extern syscall_stats_t global_syscall_stats;
+
+// called by systemcall_wrapper before dispatching a call
+extern void syscall_stats_enter(uint32_t index);
+
+// called by systemcall_wrapper once the call returns
+extern void syscall_stats_exit(uint32_t index, uint32_t start_lo, uint32_t start_hi);
+
+// returns the histogram bucket of a cycle count, also used by irq_stats
+extern uint32_t syscall_stats_bucket(uint32_t cycles);
+
+// clears a set of statistics
+extern void syscall_stats_reset(syscall_stats_t* stats);
+
+#endif /* _SYSCALL_STATS_H */
@@ -1,215 +1,572 @@
 #include "systemcall.h"
 
-// global variables to track the current and previous processes
-int32_t new_pid = -1;
-int32_t old_pid;
-
 typedef int32_t ( *function )( );
 typedef int32_t ( *read_function )( int32_t fd, void* buf, int32_t nbytes );
 typedef int32_t ( *write_function )( int32_t fd, void* buf, int32_t nbytes );
 
-// stores the current running processes
-int32_t progs[MAX_OPEN_PROGS] = {0, 0, 0, 0, 0, 0};
+// pcb of every process, indexed by pid
+// NULL means the pid is free
+static pcb_t* pcb_array[MAX_PIDS];
+spinlock_t pid_lock = SPINLOCK_INIT;
 
-// handles system call to halt
-// includes functionality for ctrl + c (user controlled keyboard interrupts)
-// Inputs: status - used to determine certain halt conditions
-// Outputs: success (0), always
-// Effects: resets pcb information and transitions between user/kernel spaces
-int32_t halt(uint8_t status) {
+// file operations of each file type, filled in by init_fops_tables
+fops_table_t fops_table[NUM_DEVICES];
 
-    // retrieve pointer to current pcb
-    pcb_t *pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
+// slab caches for per-process structures
+static kmem_cache_t* pcb_cache;
+static kmem_cache_t* fd_cache;
 
-    // current process has halted, so set the corresponding element in the progs to 0
-    progs[new_pid] = 0;
-    // make sure all files for the process are handled
+// gives back everything a process owns
+// Inputs: pcb - process to free, its fields are not valid afterwards
+// Outputs: none
+// Effects: the process must not be running, nor be the one whose stack we are on
+//          user pages shared after fork are only freed with their last owner
+static void process_free(pcb_t* pcb){
+    fpu_free(pcb);
+    user_mem_free(&pcb->mm);
+    free_pages(pcb->kernel_stack, KSTACK_ORDER);
+    free_page_directory(pcb->page_dir);
+    kmem_cache_free(fd_cache, pcb->systemcall_fd_array);
+    kmem_cache_free(pcb_cache, pcb);
+}
+
+// frees a zombie that is already out of the pid table
+// Inputs: pcb - process that exited
+// Outputs: none
+// Effects: waits until it has switched away, it may still be on its way out on another CPU
+static void process_reap(pcb_t* pcb){
+    while(pcb->on_cpu){
+        asm volatile("pause");
+    }
+    process_free(pcb);
+}
+
+// finds where a program ends in memory
+// Inputs: inode - inode of the executable
+//         header - its first ELF_HEADER_SIZE bytes
+//         file_size - its size in bytes
+// Outputs: end of the last loadable segment, or of the file if that is further
+// Effects: none
+static uint32_t image_end(uint32_t inode, const uint8_t* header, uint32_t file_size){
+    // the file is loaded as is, but uninitialized data may reach past it
+    uint32_t end = USER_IMAGE_START + file_size;
+    uint32_t phoff = *(uint32_t*)(header + ELF_PHOFF_OFFSET);
+    uint16_t phnum = *(uint16_t*)(header + ELF_PHNUM_OFFSET);
+    uint32_t phdr[ELF_PHDR_SIZE / sizeof(uint32_t)];
     int i;
-    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++){
-        close(i);
+
+    for(i = 0; i < phnum; i++){
+        if(read_data(inode, phoff + i * ELF_PHDR_SIZE, (uint8_t*)phdr, ELF_PHDR_SIZE) != ELF_PHDR_SIZE){
+            break;
+        }
+        if(phdr[PHDR_TYPE] == ELF_PT_LOAD && phdr[PHDR_VADDR] + phdr[PHDR_MEMSZ] > end){
+            end = phdr[PHDR_VADDR] + phdr[PHDR_MEMSZ];
+        }
     }
-    // update current counters
-    old_pid = new_pid;
-    new_pid = pcb->parent_pid;
-    terminal_array[sched_terminal].terminal_current_pid = new_pid;
+    return end;
+}
 
+// allocates a process and gives it a pid
+// Inputs: none
+// Outputs: the new pcb in state PROC_NEW, or NULL if there is no memory or no free pid
+// Effects: the process has a kernel stack and a page directory but no user memory yet
+static pcb_t* process_alloc(){
+    uint32_t flags;
+    int i;
 
-    uint32_t par_ebp;
-    uint32_t par_esp;
-    par_ebp = pcb->parent_ebp;
-    par_esp = pcb->parent_esp;
-    pcb->parent_ebp = 0;
-    pcb->parent_esp = 0;
+    pcb_t *pcb = kmem_cache_alloc(pcb_cache);
+    if(pcb == NULL) { return NULL; }
+    pcb->systemcall_fd_array = kmem_cache_alloc(fd_cache);
+    pcb->kernel_stack = alloc_pages(KSTACK_ORDER);
+    pcb->page_dir = new_page_directory();
+    pcb->mm.table = NULL;
+    pcb->fpu_state = NULL;
+    if(pcb->systemcall_fd_array == NULL || pcb->kernel_stack == 0 || pcb->page_dir == NULL) {
+        process_free(pcb);
+        return NULL;
+    }
 
-    terminal_array[sched_terminal].terminal_esp = par_esp;
-    terminal_array[sched_terminal].terminal_ebp = par_ebp;
+    pcb->state = PROC_NEW;
+    pcb->cpu = 0;
+    pcb->on_cpu = 0;
+    pcb->fpu_cpu = 0;
+    pcb->priority = 0;
+    pcb->slice_left = 0;
+    pcb->killed = 0;
+    pcb->wait_queue = NULL;
+    wq_init(&pcb->child_wq);
+    pcb->sleep_timer.pending = 0;
+    pcb->dl_period_us = pcb->dl_budget_us = pcb->dl_util = 0;
+    pcb->dl_throttled = 0;
+    pcb->dl_timer.pending = 0;
+    pcb->image_inode = -1;
+    pcb->exit_status = 0;
+    syscall_stats_reset(&pcb->syscall_stats);
+    memset(&pcb->cpu_stats, 0, sizeof(cpu_stats_t));
+    memset(&pcb->sched_lat, 0, sizeof(sched_lat_t));
+    pcb->wake_pending = 0;
+
+    // Find a free process ID
+    spin_lock_irqsave(&pid_lock, flags);
+    for(i = 0; i < MAX_PIDS; i++) {
+        if(pcb_array[i] == NULL) { break; }
+    }
+    if(i >= MAX_PIDS) {
+        spin_unlock_irqrestore(&pid_lock, flags);
+        process_free(pcb);
+        return NULL;
+    }
+    pcb->pid = i;
+    pcb_array[i] = pcb;
+    spin_unlock_irqrestore(&pid_lock, flags);
+    return pcb;
+}
 
-    // handle special halt status cases
-    // use a larger container/variable
-    int32_t status_32bit = status;
-    if(status_32bit == EXCEPTION_HALT){
-        status_32bit = RET_EXCEPTION_HALT;
-    } else if (status_32bit == USER_HALT){
-        puts("\nInterrupt!!! Program interrupted by user");
+// frees a process and its pid
+// Inputs: pcb - process that is not running anymore
+// Outputs: none
+// Effects: pcb is not valid afterwards
+void process_release(pcb_t* pcb){
+    uint32_t flags;
+
+    spin_lock_irqsave(&pid_lock, flags);
+    pcb_array[pcb->pid] = NULL;
+    spin_unlock_irqrestore(&pid_lock, flags);
+    process_free(pcb);
+}
+
+// sets up the kernel stack of a new process
+// the first context_switch to it enters process_start, which leaves through
+// the syscall_frame_t at the top of the stack
+// Inputs: pcb - new process, its frame must already be filled in
+// Outputs: none
+// Effects: sets pcb->context_esp
+static void prepare_context(pcb_t* pcb){
+    uint32_t* context = (uint32_t*)(KSTACK_TOP(pcb) - sizeof(syscall_frame_t)) - CONTEXT_WORDS;
+
+    memset(context, 0, CONTEXT_WORDS * sizeof(uint32_t));
+    // interrupts stay off until syscall_return
+    context[CONTEXT_EFLAGS] = EFLAGS_RESERVED;
+    context[CONTEXT_RET] = (uint32_t)process_start;
+    pcb->context_esp = (uint32_t)context;
+}
+
+// places argc and argv for a new program at the top of its stack, System V style
+// the strings go right below KEY_MEM, under them the NULL terminated argv array
+// and argc, which is where the program's esp starts
+// Inputs: pcb - new process, its address space must not be loaded
+//         command - program name followed by its arguments, separated by spaces
+// Outputs: user stack pointer to start with, or 0 if the arguments do not fit
+// Effects: maps the top page of the stack, sets pcb->argc and pcb->argv
+static uint32_t setup_args(pcb_t* pcb, const uint8_t* command){
+    uint32_t argc = 0, len = 0, i, j;
+    uint32_t base = USER_END - PAGE_SIZE;
+    uint32_t page, str, sp;
+    uint32_t* words;
+
+    // count the words and the bytes they need
+    for(i = 0; command[i] != '\0'; i++){
+        if(command[i] == ' '){ continue; }
+        if(i == 0 || command[i - 1] == ' '){ argc++; }
+        len++;
     }
+    // every word gets a terminator
+    len += argc;
 
-    // just done for visual purposes
-    putc('\n');
+    // everything has to fit in the top page of the stack
+    if(len + (argc + 2) * sizeof(uint32_t) + sizeof(uint32_t) > KEY_MEM - base){
+        return 0;
+    }
+    page = user_mem_map(&pcb->mm, base);
+    if(page == 0){
+        return 0;
+    }
 
-    // make sure a program is always running, specifically shell
-    if(new_pid == -1){
-        execute((uint8_t*)"shell");
+    str = KEY_MEM - len;
+    sp = (str & ~(sizeof(uint32_t) - 1)) - (argc + 2) * sizeof(uint32_t);
+    words = (uint32_t*)(page + (sp - base));
+    words[0] = argc;
+
+    // copy each word once, straight to where the program will see it
+    for(i = 0, j = 1; command[i] != '\0'; ){
+        if(command[i] == ' '){
+            i++;
+            continue;
+        }
+        words[j++] = str;
+        while(command[i] != ' ' && command[i] != '\0'){
+            *(uint8_t*)(page + (str++ - base)) = command[i++];
+        }
+        *(uint8_t*)(page + (str++ - base)) = '\0';
     }
+    words[j] = 0;
 
-    // sets the page table
-    // maps the program to the relevant user space
-    page_directory[USR_IDX].present = page_directory[USR_IDX].rw = page_directory[USR_IDX].us = page_directory[USR_IDX].ps = page_directory[USR_IDX].g = 1;
-    page_directory[USR_IDX].pwt = page_directory[USR_IDX].pcd = page_directory[USR_IDX].acc = page_directory[USR_IDX].avl = page_directory[USR_IDX].avl_3 = 0;
-    page_directory[USR_IDX].addy = ((uint32_t)(EIGHTMB + (new_pid * FOURMB))) >> SHIFT_12;
-    flush_tlb();
-    
+    pcb->argc = argc;
+    pcb->argv = sp + sizeof(uint32_t);
+    return sp;
+}
 
-    tss.ss0 = KERNEL_DS;
-    tss.esp0 = EIGHTMB - EIGHTKB * new_pid - 4;
- 
-    // restore the register values to the old, parent values before we jump
-    asm volatile("movl %0, %%eax;"
-                 "movl %1, %%ebp;" 
-                 "movl %2, %%esp;" 
-                 "leave;" 
-                 "ret;" 
-                : 
-                : "r"(status_32bit), "r"(par_ebp), "r"(par_esp));
+// creates a kernel thread
+// Inputs: fn - function the thread runs, must not return
+//         name - name procstat shows for the thread
+// Outputs: pcb of the thread in state PROC_NEW, or NULL if there is no memory
+// Effects: the caller makes it runnable, it runs with interrupts on
+pcb_t* kthread_create(void (*fn)(void), const int8_t* name){
+    pcb_t *pcb = process_alloc();
+    if(pcb == NULL) { return NULL; }
+
+    strncpy((int8_t*)pcb->name, name, PROC_NAME_LEN - 1);
+    pcb->name[PROC_NAME_LEN - 1] = '\0';
+    pcb->parent_pid = -1;
+    pcb->terminal = KTHREAD_TERMINAL;
+    pcb->argc = pcb->argv = 0;
+    memset(pcb->systemcall_fd_array, 0, sizeof(file_descriptor_t) * FILE_DESCRIPTOR_ARRAY_SIZE);
+
+    // kthread_start calls fn from the saved ebx
+    uint32_t* context = (uint32_t*)KSTACK_TOP(pcb) - CONTEXT_WORDS;
+    memset(context, 0, CONTEXT_WORDS * sizeof(uint32_t));
+    context[CONTEXT_EFLAGS] = EFLAGS_RESERVED;
+    context[CONTEXT_EBX] = (uint32_t)fn;
+    context[CONTEXT_RET] = (uint32_t)kthread_start;
+    pcb->context_esp = (uint32_t)context;
+    return pcb;
+}
 
-    // never reaches here
-    // 01134 = Hello :)
-    return 01134;
+// asks a process to halt
+// Inputs: pid - process to kill
+// Outputs: returns success (0) or fail (-1) if there is no such user process
+// Effects: wakes the process up if it is blocked, it halts with USER_HALT
+//          the next time it returns to user mode
+int32_t process_kill(int32_t pid){
+    uint32_t flags;
+    pcb_t *pcb;
+
+    // the pid lock keeps the process from being freed under us
+    spin_lock_irqsave(&pid_lock, flags);
+    pcb = get_pcb(pid);
+    if(pcb == NULL || pcb->terminal == KTHREAD_TERMINAL) {
+        spin_unlock_irqrestore(&pid_lock, flags);
+        return -1;
+    }
+    pcb->killed = 1;
+    // a process blocked in a read would not notice until its input arrives
+    wq_wake_process(pcb);
+    spin_unlock_irqrestore(&pid_lock, flags);
+    return 0;
 }
 
-// Handles system call to execute
-// Inputs: command - the command to execute
-// Outputs: returns fail (-1) or 0 on success
-// Effects: creates a new process and executes the command
-int32_t execute(const uint8_t* command) {
-    // Print a newline character and clear the buffer
-    putc('\n');
-    clear_buffer();
+// halts the running process if ctrl + c killed it
+// Inputs: none
+// Outputs: none
+// Effects: does not return if the process was killed, called by syscall_return
+//          and the interrupt wrappers right before they go back to user mode
+void process_kill_check(void){
+    pcb_t *pcb = current_pcb();
+    if(pcb != NULL && pcb->killed){
+        halt(USER_HALT);
+    }
+}
 
-    // Save the current stack pointer (esp) and base pointer (ebp)
-    uint32_t parent_esp, parent_ebp;
-    asm volatile("movl %%esp, %[parent_esp];"
-                 "movl %%ebp, %[parent_ebp];"
-                : [parent_esp] "=m" (parent_esp), [parent_ebp] "=m" (parent_ebp)
-                :
-                : "memory");
+// tells a sleeping process to stop waiting
+// Inputs: none
+// Outputs: returns 1 if the running process was killed, 0 otherwise
+// Effects: none
+int32_t process_killed(void){
+    pcb_t *pcb = current_pcb();
+    return pcb != NULL && pcb->killed;
+}
 
+// creates a process running a program
+// Inputs: command - program name followed by its arguments
+//         parent_pid - process to report the exit status to, or -1
+//         terminal - terminal the program runs in
+// Outputs: pid of the new process, or fail (-1)
+// Effects: the process is runnable right away, it loads its own image when it first runs
+static int32_t process_exec(const uint8_t* command, int32_t parent_pid, int32_t terminal){
     // Initialize directory entry and buffer
     dentry_t dentry;
-    uint8_t buf[DATA_BLOCK_SIZE];
+    // only the ELF header is read here, the image is loaded straight into user memory
+    uint8_t buf[ELF_HEADER_SIZE];
 
     // Parse the command to get the file name
     int i = 0, j = 0;
-    uint8_t cur_file[MAX_NAME_LENGTH];
+    uint8_t cur_file[MAX_NAME_LENGTH + 1];
+
+    if(command == NULL) return -1;
 
     while(command[i] == ' ') i++;
 
     while(command[i] != ' ' && command[i] != '\0') {
-        if(j >= MAX_NAME_LENGTH) return 0;
+        if(j >= MAX_NAME_LENGTH) return -1;
         cur_file[j++] = command[i++];
     }
 
     cur_file[j] = '\0';
 
     // Check for errors and read the directory entry and data
-    if(new_pid >= MAX_OPEN_PROGS - 1 || command == NULL || command == '\0' || strlen((int8_t*)command) > BUF_SIZE ||
+    if(command[0] == '\0' ||
     read_dentry_by_name((uint8_t*)cur_file, &dentry) == -1 ||
-    read_data(dentry.inode_num, 0, buf, RAND_BUF_SIZE) == -1 ||
+    read_data(dentry.inode_num, 0, buf, ELF_HEADER_SIZE) == -1 ||
     (buf[0] != ASCII_DEL) || (buf[1] != ASCII_E) || (buf[2] != ASCII_L) || (buf[3] != ASCII_F)) return -1;
 
-    // Update the current process ID
-    old_pid = terminal_array[current_terminal].terminal_current_pid;
-    for(i = 0; i < MAX_OPEN_PROGS; i++) {
-        if(progs[i] == CLOSE) {
-            progs[i] = OPEN;
-            new_pid = i;
-            break;
-        }
+    // The program has to leave room for the stack
+    uint32_t file_size = (uint32_t)(((inode_t*)(inode_ptr + dentry.inode_num))->length);
+    uint32_t end = image_end(dentry.inode_num, buf, file_size);
+    if(end > USER_STACK_LIMIT) { return -1; }
+
+    // Get the process control block (PCB) and an empty address space,
+    // the program's pages are allocated as it is loaded
+    pcb_t *pcb = process_alloc();
+    if(pcb == NULL) { return -1; }
+    if(user_mem_init(&pcb->mm, end) == -1) {
+        process_release(pcb);
+        return -1;
+    }
+    user_mem_install(&pcb->mm, pcb->page_dir);
+    uint32_t user_esp = setup_args(pcb, command);
+    if(user_esp == 0) {
+        process_release(pcb);
+        return -1;
     }
-    if(i > MAX_OPEN_PROGS - 1) { return -1; }
 
-    terminal_array[current_terminal].terminal_current_pid = new_pid;
+    // Initialize the PCB for the new process
+    pcb->parent_pid = parent_pid;
+    pcb->terminal = terminal;
+    strcpy((int8_t*)pcb->name, (int8_t*)cur_file);
+    pcb->image_inode = dentry.inode_num;
+    pcb->image_size = file_size;
+
+    // Initialize the file descriptors for the new process
+    for(i = 0; i < 2; i++) {
+        pcb->systemcall_fd_array[i].file_operation_table_ptr = get_fops_table(TERMINAL_INDEX);
+        pcb->systemcall_fd_array[i].inode = -1;
+        pcb->systemcall_fd_array[i].file_position = 0;
+        pcb->systemcall_fd_array[i].flags = 1;
+    }
 
-    // Initialize the process control block (PCB) for the new process
-    pcb_t *pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
-    memset(pcb->arg_buff, '\0', sizeof(pcb->arg_buff));
-    strcpy((int8_t*)pcb->arg_buff, (int8_t*)command);
+    for(i = 2; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++) pcb->systemcall_fd_array[i].flags = 0;
 
     // Calculate the entry point of the new process
     int eip = 0;
     for(i = 0; i < EIP_BYTES; i++) eip |= buf[EIP_OFFSET + i] << (BYTE_BITS * i);
 
-    // Map the new process into the page directory
-    page_directory[USR_IDX].present = page_directory[USR_IDX].rw = page_directory[USR_IDX].us = page_directory[USR_IDX].ps = page_directory[USR_IDX].g = 1;
-    page_directory[USR_IDX].pwt = page_directory[USR_IDX].pcd = page_directory[USR_IDX].acc = page_directory[USR_IDX].avl = page_directory[USR_IDX].avl_3 = 0;
-    page_directory[USR_IDX].addy = ((uint32_t)(EIGHTMB + (new_pid * FOURMB))) >> SHIFT_12;
-    flush_tlb();
+    // The process enters user mode at the entry point with argc on top of its stack
+    syscall_frame_t* frame = (syscall_frame_t*)(KSTACK_TOP(pcb) - sizeof(syscall_frame_t));
+    memset(frame, 0, sizeof(syscall_frame_t));
+    frame->eip = eip;
+    frame->cs = USER_CS;
+    frame->eflags = FLAG_MASK | EFLAGS_RESERVED;
+    frame->esp = user_esp;
+    frame->ss = USER_DS;
+    prepare_context(pcb);
+
+    sched_wakeup(pcb);
+    return pcb->pid;
+}
 
-    // Read the file data into memory
-    uint32_t file_size = (uint32_t)(((inode_t*)(inode_ptr + dentry.inode_num))->length);
-    read_data((uint32_t)dentry.inode_num, 0, (uint8_t*)EXEC_LOAD_ADDRESS, file_size);
+// collects the exit status of a child
+// Inputs: pcb - the calling process
+//         pid - child to wait for, or -1 for any child
+//         options - WNOHANG to return right away if no child has exited
+//         status - receives the exit status
+// Outputs: pid of the child, 0 with WNOHANG if none has exited, or fail (-1) if there is no such child
+// Effects: blocks until a child exits, frees it
+static int32_t wait_child(pcb_t* pcb, int32_t pid, int32_t options, int32_t* status){
+    uint32_t flags;
+    int32_t found;
+    pcb_t* child;
+    int i;
 
-    if(new_pid < 3){
-        old_pid = -1;
+    spin_lock_irqsave(&pid_lock, flags);
+    while(1){
+        found = 0;
+        for(i = 0; i < MAX_PIDS; i++){
+            child = pcb_array[i];
+            if(child == NULL || child->parent_pid != pcb->pid || (pid != -1 && child->pid != pid)){
+                continue;
+            }
+            found = 1;
+            if(child->state == PROC_ZOMBIE){
+                *status = child->exit_status;
+                pid = child->pid;
+                pcb_array[i] = NULL;
+                spin_unlock_irqrestore(&pid_lock, flags);
+                process_reap(child);
+                return pid;
+            }
+        }
+        if(!found || (options & WNOHANG)){
+            spin_unlock_irqrestore(&pid_lock, flags);
+            return found ? 0 : -1;
+        }
+        // a killed parent stops waiting, it halts on its way back to user mode
+        if(pcb->killed){
+            spin_unlock_irqrestore(&pid_lock, flags);
+            return -1;
+        }
+        // process_exit wakes us up when a child is done, it needs the pid
+        // lock to mark the child a zombie, so the wakeup cannot get lost
+        spin_lock(&pcb->child_wq.lock);
+        spin_unlock(&pid_lock);
+        wq_sleep(&pcb->child_wq);
+        spin_unlock(&pcb->child_wq.lock);
+        spin_lock(&pid_lock);
     }
+}
 
-    // Update the PCB with the new process information
-    pcb->parent_pid = old_pid;
-    pcb->pid = new_pid;
-    pcb->parent_ebp = parent_ebp;
-    pcb->parent_esp = parent_esp;
+// ends the current process
+// Inputs: pcb - the running process
+//         status - exit status for its parent
+// Outputs: none
+// Effects: never returns, the pcb and kernel stack stay around until the parent
+//          collects the status, or until we have switched away if there is no parent
+static void process_exit(pcb_t* pcb, int32_t status){
+    pcb_t *other, *zombies = NULL;
+    int i;
 
-    // Initialize the file descriptors for the new process
-    for(i = 0; i < 2; i++) {
-        pcb->systemcall_fd_array[i].file_operation_table_ptr = get_fops_table(TERMINAL_INDEX);
-        pcb->systemcall_fd_array[i].inode = -1;
-        pcb->systemcall_fd_array[i].file_position = 0;
-        pcb->systemcall_fd_array[i].flags = 1;
+    // interrupts stay off until we have switched away for good
+    cli();
+
+    // a timer must not fire for a pcb that is gone
+    timer_del(&pcb->sleep_timer);
+    sched_set_deadline(pcb, 0, 0);
+
+    // give the memory back now, run on the kernel's page directory until we switch
+    load_page_directory(page_directory);
+    user_mem_free(&pcb->mm);
+    free_page_directory(pcb->page_dir);
+    pcb->page_dir = NULL;
+    pcb->exit_status = status;
+
+    // make sure a program is always running, specifically shell
+    if(terminal_array[pcb->terminal].shell_pid == pcb->pid){
+        start_shell(pcb->terminal);
     }
 
-    for(i = 2; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++) pcb->systemcall_fd_array[i].flags = 0;
+    spin_lock(&pid_lock);
+    // children outlive us, the ones that are already done can go right away
+    for(i = 0; i < MAX_PIDS; i++){
+        other = pcb_array[i];
+        if(other == NULL || other->parent_pid != pcb->pid){
+            continue;
+        }
+        other->parent_pid = -1;
+        if(other->state == PROC_ZOMBIE){
+            pcb_array[i] = NULL;
+            other->run_next = zombies;
+            zombies = other;
+        }
+    }
 
-    // Update the task state segment (TSS) for the new process
-    pcb->esp = tss.esp0; 
-    pcb->ss = tss.ss0;   
-
-    tss.ss0 = KERNEL_DS;
-    tss.esp0 = EIGHTMB - EIGHTKB * new_pid - EIP_BYTES;
-
-    pcb->program_ebp = tss.esp0;
-    pcb->program_esp = tss.esp0;
-
-    // Prepare for context switch to the new process
-    asm volatile ("leal HALT_RET, %%eax;"
-                :
-                :
-                : "eax", "memory");
-    asm volatile("pushl %[USR_DS];"
-                 "pushl %[BOT];"
-                 "pushfl;"
-                 "popl %%ebx;"
-                 "orl %[IF_EN], %%ebx;"
-                 "pushl %%ebx;"
-                 "pushl %[USR_CS];"
-                 "pushl %[ip];" 
-                : 
-                : [USR_DS] "i" (USER_DS), [BOT] "i" (KEY_MEM), [IF_EN] "i" (FLAG_MASK), [USR_CS] "i" (USER_CS), [ip] "r" (eip) 
-                : "ebx");
-    
-    // Perform the context switch
-    asm volatile("iret");
-    asm volatile("HALT_RET:");
+    other = get_pcb(pcb->parent_pid);
+    if(other != NULL){
+        pcb->state = PROC_ZOMBIE;
+        wq_wake_all(&other->child_wq);
+    } else {
+        pcb->state = PROC_DEAD;
+    }
+    spin_unlock(&pid_lock);
 
-    return 0;
+    while(zombies != NULL){
+        other = zombies;
+        zombies = other->run_next;
+        process_reap(other);
+    }
+    schedule();
+}
+
+// handles system call to halt
+// includes functionality for ctrl + c (user controlled keyboard interrupts)
+// Inputs: status - used to determine certain halt conditions
+// Outputs: fail (-1) if no process is running, otherwise does not return
+// Effects: closes the process's files and ends it
+int32_t halt(uint8_t status) {
+
+    // retrieve pointer to current pcb
+    pcb_t *pcb = current_pcb();
+    // ctrl + c can come in while the kernel is idle
+    if(pcb == NULL){
+        return -1;
+    }
+
+    // make sure all files for the process are handled
+    int i;
+    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++){
+        close(i);
+    }
+
+    // handle special halt status cases
+    // use a larger container/variable
+    int32_t status_32bit = status;
+    if(status_32bit == EXCEPTION_HALT){
+        status_32bit = RET_EXCEPTION_HALT;
+    } else if (status_32bit == USER_HALT){
+        puts("\nInterrupt!!! Program interrupted by user");
+    }
+
+    // just done for visual purposes
+    putc('\n');
+
+    process_exit(pcb, status_32bit);
+
+    // never reaches here
+    // 01134 = Hello :)
+    return 01134;
+}
+
+// Handles system call to execute
+// Inputs: command - the command to execute
+// Outputs: returns fail (-1) or the program's exit status
+// Effects: creates a new process and waits for it to finish
+int32_t execute(const uint8_t* command) {
+    // Print a newline character and clear the buffer
+    putc('\n');
+    clear_buffer();
+
+    pcb_t *pcb = current_pcb();
+    if(pcb == NULL) { return -1; }
+
+    int32_t status;
+    int32_t pid = process_exec(command, pcb->pid, pcb->terminal);
+    if(pid == -1) { return -1; }
+
+    // the child gets ctrl + c while we wait for it, unless we run in the background
+    terminal_t* term = &terminal_array[pcb->terminal];
+    uint8_t foreground = (term->fg_pid == pcb->pid);
+    if(foreground) { term->fg_pid = pid; }
+    pid = wait_child(pcb, pid, 0, &status);
+    if(foreground) { term->fg_pid = pcb->pid; }
+    return (pid == -1) ? -1 : status;
+}
+
+// Starts the shell of a terminal
+// Inputs: terminal - terminal to start a shell in
+// Outputs: pid of the shell, or fail (-1)
+// Effects: the shell has no parent, process_exit starts a new one when it exits
+int32_t start_shell(int32_t terminal) {
+    int32_t pid = process_exec((uint8_t*)"shell", -1, terminal);
+
+    terminal_array[terminal].shell_pid = pid;
+    terminal_array[terminal].fg_pid = pid;
+    terminal_array[terminal].on_off_flag = (pid != -1);
+    return pid;
+}
+
+// Runs in a new process before it first enters user mode
+// Inputs: none
+// Outputs: none
+// Effects: loads the program image of an executed process
+void process_entry() {
+    pcb_t *pcb = current_pcb();
+
+    schedule_tail();
+    // nothing is held here, loading the image may be preempted
+    sti();
+
+    if(pcb->image_inode != -1) {
+        read_data((uint32_t)pcb->image_inode, 0, (uint8_t*)EXEC_LOAD_ADDRESS, pcb->image_size);
+        pcb->image_inode = -1;
+    }
 }
 
 // handles system call to read
@@ -221,28 +578,15 @@ int32_t execute(const uint8_t* command) {
 int32_t read( int32_t fd, void* buf, int32_t nbytes )
 {
     // retrieve pointer to current pcb
-    pcb_t * pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
+    pcb_t * pcb = current_pcb();
 
     // make sure the given fd is valid
-    if(fd > MAX_FD || fd < MIN_FD || fd == 1 || buf == NULL || pcb->systemcall_fd_array[fd].flags == 0) { return -1; }
-
-    // synchronize the global file descriptor array with the current program's array
-    int i;
-    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++) {
-        file_descriptor_array[i] = pcb->systemcall_fd_array[i];
-    }
-
-    // try to call read function
-    int retval = (pcb->systemcall_fd_array[fd].file_operation_table_ptr->read)(fd, buf, nbytes);
+    if(pcb == NULL || fd > MAX_FD || fd < MIN_FD || fd == 1 || buf == NULL || pcb->systemcall_fd_array[fd].flags == 0) { return -1; }
 
-    // restore the old file array information
-    // system's and program's file information will be different, especially after calling a read function
-    // we have to make sure the changes are stored for the current program (since the call to read only updates the system's file information)
-    for(i = 0; i < FILE_DESCRIPTOR_ARRAY_SIZE; i++) {
-        pcb->systemcall_fd_array[i] = file_descriptor_array[i];
-    }
-
-    return retval; 
+    // the read works on our own descriptor, so the file position it moves is ours
+    // even if it sleeps and other processes read in the meantime
+    file_descriptor_t* file = &pcb->systemcall_fd_array[fd];
+    return (file->file_operation_table_ptr->read)(file, buf, nbytes);
 }
 
 
@@ -255,10 +599,10 @@ int32_t read( int32_t fd, void* buf, int32_t nbytes )
 int32_t write( int32_t fd, const void* buf, int32_t nbytes )
 {
     // retrieve pointer to current pcb
-    pcb_t * pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
+    pcb_t * pcb = current_pcb();
 
     // make sure the given fd is valid
-    if(fd > MAX_FD || fd <= MIN_FD || buf == NULL || pcb->systemcall_fd_array[fd].flags == 0) { return -1; }
+    if(pcb == NULL || fd > MAX_FD || fd <= MIN_FD || buf == NULL || pcb->systemcall_fd_array[fd].flags == 0) { return -1; }
 
     // try to call write function
     return (pcb->systemcall_fd_array[ fd ].file_operation_table_ptr->write)( fd, buf, nbytes ); 
@@ -275,7 +619,8 @@ int32_t open( const uint8_t* filename )
     if( read_dentry_by_name( filename, &cur_dentry ) == -1 ) { return -1; }
 
     // retrieve pointer to current pcb
-    pcb_t * pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
+    pcb_t * pcb = current_pcb();
+    if(pcb == NULL) { return -1; }
 
     // try to get a free index in file descriptor array
     int i;
@@ -293,8 +638,11 @@ int32_t open( const uint8_t* filename )
     pcb->systemcall_fd_array[i].flags = 1;
     pcb->systemcall_fd_array[i].file_position = 0;
 
-    // try to open file, if cannot open, fail
-    if((pcb->systemcall_fd_array[i].file_operation_table_ptr->open)(filename) == -1){ return -1; }
+    // try to open file, if cannot open, give the descriptor back and fail
+    if((pcb->systemcall_fd_array[i].file_operation_table_ptr->open)(filename) == -1){
+        pcb->systemcall_fd_array[i].flags = CLOSE;
+        return -1;
+    }
 
     return ( i );
 }
@@ -309,8 +657,9 @@ int32_t close (int32_t fd) {
         return -1;
     }
     // retrieve pointer to current pcb
-    pcb_t * pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
-    
+    pcb_t * pcb = current_pcb();
+    if(pcb == NULL) { return -1; }
+
     // check if file is currently closed
     if (pcb->systemcall_fd_array[fd].flags == 0) { return -1; }
     // if not closed, close the file
@@ -328,44 +677,32 @@ int32_t getargs( uint8_t* buf, int32_t nbytes )
     // check for valid inputs
     if (buf == NULL || nbytes < 1){ return -1; }
 
-    pcb_t * pcb = (pcb_t *)(EIGHTMB - EIGHTKB * (new_pid + 1));
-
-    uint8_t command_buffer[BUF_SIZE];
-    strcpy((int8_t*)command_buffer, (int8_t*)pcb->arg_buff);
-
-    int i = 0;
-    // flags for spaces in between "words" in the command
-    int flag1 = 0;
-    int flag2 = 0;
-    while((command_buffer[i] != '\0')){
-        if (command_buffer[i] != ' '){
-            flag1 = 1;
+    pcb_t * pcb = current_pcb();
+    if (pcb == NULL){ return -1; }
+
+    // execute already split the command into argv on the user stack,
+    // join everything after the program name back together with single spaces
+    // the program may have changed argv, so every pointer is checked
+    uint32_t* argv = (uint32_t*)pcb->argv;
+    uint32_t i, arg;
+    int32_t len = 0;
+    for(i = 1; i < pcb->argc; i++){
+        if(i > 1){
+            if(len >= nbytes){ return -1; }
+            buf[len++] = ' ';
         }
-        if((command_buffer[i] == ' ') && (flag1 == 1)){
-            flag2 = 1;
+        for(arg = argv[i]; arg >= USER_START && arg < USER_END && *(uint8_t*)arg != '\0'; arg++){
+            // fail if args are too long
+            if(len >= nbytes){ return -1; }
+            buf[len++] = *(uint8_t*)arg;
         }
-        if((command_buffer[i] != ' ') && (flag2 == 1)){
-            break;
-        }
-        i++;
-    }
-    // by this point i should store the start of args
-    uint8_t args[BUF_SIZE];    
-    memset( args, '\0', BUF_SIZE );
-
-    int arg_offset = i;
-    while (command_buffer[i] != '\0'){
-        args[i - arg_offset] = command_buffer[i];
-        i++;
     }
 
-    // fail if args are too long or no args were found
-    if (!(strlen((int8_t*)args) <= nbytes) || (strlen((int8_t*)args) < 1)){
-        return -1;
-    }
-    memcpy(buf, args, nbytes);
+    // fail if no args were found
+    if (len < 1){ return -1; }
+    if (len < nbytes){ buf[len] = '\0'; }
 
-    // if memcpy was successful, return success
+    // if the copy was successful, return success
     return 0; 
 }   
 
@@ -376,31 +713,393 @@ int32_t getargs( uint8_t* buf, int32_t nbytes )
 // Outputs: returns success (0) or fails (-1)
 // Effects: accesses paging information and changes *screen_start
 int32_t vidmap (uint8_t** screen_start){
+    pcb_t* pcb = current_pcb();
+
     // check valid location
     // should be within user space
-    if(screen_start == NULL || (uint32_t)screen_start < USER_START || (uint32_t)screen_start >= KEY_MEM){
+    if(pcb == NULL || screen_start == NULL || (uint32_t)screen_start < USER_START || (uint32_t)screen_start >= KEY_MEM){
         return -1;
     }
     // initialize new page directory entry for video memory
-    page_directory[VID_IDX].present = page_directory[VID_IDX].rw = page_directory[VID_IDX].us = 1;
+    // in the calling process's own page directory
+    page_directory_entry_t* pd = pcb->page_dir;
+    page_directory_entry_t pde = pd[VID_IDX];
+    pde.present = pde.rw = pde.us = 1;
     // size of the page will be 4KB, not 4MB
-    page_directory[VID_IDX].ps = 0;
-    page_directory[VID_IDX].addy = ((uint32_t)vid_table >> SHIFT_12);
+    pde.ps = pde.g = 0;
+    // each terminal has its own table, pointing at the screen or at the
+    // terminal's backing page, so it does not matter which CPU we run on
+    pde.addy = ((uint32_t)vid_tables[pcb->terminal] >> SHIFT_12);
 
-    // set up page table entry at correct location
-    vid_table[0].present = vid_table[0].rw = vid_table[0].us = 1;
-    vid_table[0].addy = VIDEO_START >> SHIFT_12;
-    
+    // only the entry that changed is invalidated
+    set_pde(pd, VID_IDX, pde);
 
     // set location of user video memory
     *screen_start = (uint8_t *)(USER_VID_MEM);
 
-    // new page loaded, so we have to flush the tlb
-    flush_tlb();
+    return 0;
+}
+
+// checks that a buffer a process passed in lies entirely in user memory
+// Inputs: buf - start of the buffer
+//         nbytes - its size, at least 1
+// Outputs: returns 1 if it does, 0 if any of it is outside or it wraps around
+static int32_t user_buf_ok (const void* buf, int32_t nbytes){
+    return (uint32_t)buf >= USER_START && (uint32_t)buf < USER_END &&
+           (uint32_t)nbytes <= USER_END - (uint32_t)buf;
+}
+
+// copies system call counters and latency histograms to the user
+// Inputs: pid - process to report on, or SYSSTAT_GLOBAL for every process combined
+//         buf - buffer that receives a syscall_stats_t
+//         nbytes - size of buf
+// Outputs: returns the number of bytes copied or fail (-1) on a bad pid or buffer
+//          or when there is no memory for the copy
+// Effects: clobbers up to nbytes of buf
+int32_t sysstat (int32_t pid, void* buf, int32_t nbytes){
+    uint32_t flags;
+    syscall_stats_t* copy;
+    pcb_t* pcb;
+
+    if(buf == NULL || nbytes < 1 || !user_buf_ok(buf, nbytes)){
+        return -1;
+    }
+    if(nbytes > sizeof(syscall_stats_t)){
+        nbytes = sizeof(syscall_stats_t);
+    }
+    // too big for the kernel stack
+    copy = kmalloc(sizeof(syscall_stats_t));
+    if(copy == NULL){
+        return -1;
+    }
+
+    // copy under the pid lock so the process is not freed while we look,
+    // then to the user, which may fault
+    spin_lock_irqsave(&pid_lock, flags);
+    if(pid == SYSSTAT_GLOBAL){
+        memcpy(copy, &global_syscall_stats, nbytes);
+    } else if((pcb = get_pcb(pid)) != NULL){
+        memcpy(copy, &pcb->syscall_stats, nbytes);
+    } else {
+        spin_unlock_irqrestore(&pid_lock, flags);
+        kfree(copy);
+        return -1;
+    }
+    spin_unlock_irqrestore(&pid_lock, flags);
+
+    memcpy(buf, copy, nbytes);
+    kfree(copy);
+    return nbytes;
+}
+
+// copies kernel statistics to the user
+// Inputs: which - KSTAT_KMEM for slab cache usage (an array of kmem_stat_t)
+//                 KSTAT_TLB for TLB flush counters (a tlb_stats_t)
+//                 KSTAT_IRQ for interrupts-off time (an array of irq_stats_t)
+//                 KSTAT_SCHED_LAT for wakeup latencies (a sched_lat_report_t)
+//                 KSTAT_FAIR_SHARE for each terminal's CPU share and usage (an array of fair_stat_t)
+//         buf - buffer that receives the statistics
+//         nbytes - size of buf
+// Outputs: returns the number of bytes copied or fail (-1) on a bad which or buffer
+// Effects: clobbers up to nbytes of buf
+int32_t kstat (int32_t which, void* buf, int32_t nbytes){
+    // every case copies to buf
+    if(buf == NULL || nbytes < 1 || !user_buf_ok(buf, nbytes)){
+        return -1;
+    }
+
+    switch(which){
+        case KSTAT_KMEM:
+        {
+            kmem_stat_t stats[MAX_CACHES];
+            int32_t size = kmem_get_stats(stats, MAX_CACHES) * sizeof(kmem_stat_t);
+            if(nbytes > size){
+                nbytes = size;
+            }
+            memcpy(buf, stats, nbytes);
+            return nbytes;
+        }
+        case KSTAT_TLB:
+            if(nbytes > sizeof(tlb_stats_t)){
+                nbytes = sizeof(tlb_stats_t);
+            }
+            memcpy(buf, &tlb_stats, nbytes);
+            return nbytes;
+        case KSTAT_IRQ:
+            if(nbytes > sizeof(irq_stats)){
+                nbytes = sizeof(irq_stats);
+            }
+            memcpy(buf, irq_stats, nbytes);
+            return nbytes;
+        case KSTAT_SCHED_LAT:
+        {
+            sched_lat_report_t report;
+            sched_lat_get(&report);
+            if(nbytes > sizeof(report)){
+                nbytes = sizeof(report);
+            }
+            memcpy(buf, &report, nbytes);
+            return nbytes;
+        }
+        case KSTAT_FAIR_SHARE:
+        {
+            fair_stat_t stats[FAIR_GROUPS];
+            sched_fair_get(stats);
+            if(nbytes > sizeof(stats)){
+                nbytes = sizeof(stats);
+            }
+            memcpy(buf, stats, nbytes);
+            return nbytes;
+        }
+        default:
+            return -1;
+    }
+}
+
+// creates a copy of the calling process
+// user pages are shared copy-on-write, the first write by either side copies them
+// Inputs: none
+// Outputs: returns the child's pid in the parent, 0 in the child, or fail (-1)
+// Effects: both processes are runnable afterwards
+int32_t fork (void){
+    pcb_t *parent = current_pcb();
+    if(parent == NULL) { return -1; }
+
+    // the child gets its own pcb, file array, kernel stack and page tables
+    pcb_t *pcb = process_alloc();
+    if(pcb == NULL) { return -1; }
+    // user pages are shared, both sides lose write access until they fault
+    if(user_mem_fork(&pcb->mm, &parent->mm) == -1) {
+        process_release(pcb);
+        return -1;
+    }
+    if(fpu_fork(pcb, parent) == -1) {
+        process_release(pcb);
+        return -1;
+    }
+    user_mem_install(&pcb->mm, pcb->page_dir);
+    // a vidmap of the parent stays valid in the child
+    pcb->page_dir[VID_IDX] = parent->page_dir[VID_IDX];
+
+    // copy everything else from the parent
+    memcpy(pcb->systemcall_fd_array, parent->systemcall_fd_array, sizeof(file_descriptor_t) * FILE_DESCRIPTOR_ARRAY_SIZE);
+    memcpy(pcb->name, parent->name, sizeof(pcb->name));
+    pcb->argc = parent->argc;
+    pcb->argv = parent->argv;
+    pcb->parent_pid = parent->pid;
+    pcb->terminal = parent->terminal;
+
+    // the child returns to user mode through a copy of the parent's system call frame
+    syscall_frame_t* frame = (syscall_frame_t*)(KSTACK_TOP(pcb) - sizeof(syscall_frame_t));
+    memcpy(frame, (void*)(KSTACK_TOP(parent) - sizeof(syscall_frame_t)), sizeof(syscall_frame_t));
+    prepare_context(pcb);
+
+    sched_wakeup(pcb);
+    return pcb->pid;
+}
+
+// waits for a child process to exit
+// Inputs: pid - child to wait for, or -1 for any child
+//         status - receives the child's exit status, may be NULL
+//         options - WNOHANG to return right away if no child has exited
+// Outputs: returns the child's pid, 0 with WNOHANG if none has exited, or fail (-1)
+// Effects: the child's pid is free again afterwards
+int32_t waitpid (int32_t pid, int32_t* status, int32_t options){
+    int32_t exit_status;
+    pcb_t *pcb = current_pcb();
+
+    if(pcb == NULL){
+        return -1;
+    }
+    if(status != NULL && ((uint32_t)status < USER_START || (uint32_t)status > USER_END - sizeof(int32_t))){
+        return -1;
+    }
+    pid = wait_child(pcb, pid, options, &exit_status);
+    if(pid > 0 && status != NULL){
+        *status = exit_status;
+    }
+    return pid;
+}
+
+// gives up the rest of the time slice
+// Inputs: none
+// Outputs: returns success (0) or fail (-1) if no process is running
+// Effects: other runnable processes run before the caller gets the CPU back
+int32_t yield (void){
+    if(current_pcb() == NULL){
+        return -1;
+    }
+    schedule();
+    return 0;
+}
+
+// reports CPU usage of every process
+// Inputs: buf - array to fill, the first entries are the idle tasks of each CPU
+//         count - number of entries in buf
+// Outputs: returns the number of entries filled, or fail (-1)
+// Effects: none
+int32_t procstat (proc_info_t* buf, int32_t count){
+    uint32_t flags;
+    int32_t i, j, n = 0;
+    proc_info_t info;
+    pcb_t* pcb;
+
+    if(buf == NULL || count < 1 || (uint32_t)buf < USER_START ||
+       (uint32_t)count > (USER_END - (uint32_t)buf) / sizeof(proc_info_t)){
+        return -1;
+    }
+
+    // the idle tasks come first, they are not in the pid table
+    for(i = -(int32_t)nr_cpus; i < MAX_PIDS && n < count; i++){
+        // copy under the pid lock so the process is not freed while we look,
+        // then to the user, which may fault
+        spin_lock_irqsave(&pid_lock, flags);
+        pcb = (i < 0) ? &idle_tasks[i + nr_cpus] : pcb_array[i];
+        if(pcb != NULL){
+            info.pid = pcb->pid;
+            info.parent_pid = pcb->parent_pid;
+            info.terminal = pcb->terminal;
+            info.state = pcb->state;
+            memcpy(info.name, pcb->name, PROC_NAME_LEN);
+            info.user_ticks = pcb->cpu_stats.user_ticks;
+            info.kernel_ticks = pcb->cpu_stats.kernel_ticks;
+            info.cycles_lo = (uint32_t)pcb->cpu_stats.cycles;
+            info.cycles_hi = (uint32_t)(pcb->cpu_stats.cycles >> 32);
+            info.nvcsw = pcb->cpu_stats.nvcsw;
+            info.nivcsw = pcb->cpu_stats.nivcsw;
+            info.priority = pcb->priority;
+            info.sched_lat = pcb->sched_lat;
+            info.syscalls = 0;
+            for(j = 0; j < NUM_SYSCALLS; j++){
+                info.syscalls += pcb->syscall_stats.calls[j];
+            }
+        }
+        spin_unlock_irqrestore(&pid_lock, flags);
+        if(pcb != NULL){
+            buf[n++] = info;
+        }
+    }
+    return n;
+}
+
+// reads or changes the scheduler tunables
+// Inputs: op - SCHED_GET to copy the tunables into buf, SCHED_SET to install the ones in buf
+//         buf - user sched_tunables_t
+//         nbytes - size of buf, must be at least sizeof(sched_tunables_t)
+// Outputs: returns success (0) or fail (-1) on a bad op, buffer or value
+// Effects: SCHED_SET changes how every process is scheduled
+int32_t schedctl (int32_t op, void* buf, int32_t nbytes){
+    sched_tunables_t tunables;
+
+    if(buf == NULL || nbytes < (int32_t)sizeof(sched_tunables_t) || (uint32_t)buf < USER_START ||
+       (uint32_t)buf > USER_END - sizeof(sched_tunables_t)){
+        return -1;
+    }
+    switch(op){
+        case SCHED_GET:
+            memcpy(buf, &sched_tunables, sizeof(sched_tunables_t));
+            return 0;
+        case SCHED_SET:
+            memcpy(&tunables, buf, sizeof(sched_tunables_t));
+            return sched_set_tunables(&tunables);
+        default:
+            return -1;
+    }
+}
 
+// reads a clock
+// Inputs: clock_id - which clock, only CLOCK_MONOTONIC is known
+//         ts - where to put the time
+// Outputs: returns success (0) or fail (-1) on a bad clock or buffer
+// Effects: none
+int32_t clock_gettime (int32_t clock_id, timespec_t* ts){
+    if(clock_id != CLOCK_MONOTONIC || (uint32_t)ts < USER_START ||
+       (uint32_t)ts > USER_END - sizeof(timespec_t)){
+        return -1;
+    }
+    ns_to_timespec(clock_ns(), ts);
     return 0;
 }
 
+// makes the calling process a deadline process, or a normal one again
+// Inputs: period_us - how often it needs the CPU, 0 to go back to normal scheduling
+//         budget_us - how much CPU time it needs every period
+// Outputs: returns success (0) or fail (-1) on bad values or if the CPUs
+//          cannot fit the budget next to the deadline processes they already have
+// Effects: the process runs before every normal process for budget_us every period_us
+int32_t sched_deadline (int32_t period_us, int32_t budget_us){
+    pcb_t* pcb = current_pcb();
+
+    if(pcb == NULL || period_us < 0 || budget_us < 0){
+        return -1;
+    }
+    return sched_set_deadline(pcb, period_us, budget_us);
+}
+
+// processes in sleep, their timer wakes them up
+static wait_queue_t sleep_wq;
+
+// ends a sleep
+// Inputs: data - pcb of the sleeping process
+// Outputs: none
+// Effects: runs from the PIT interrupt
+static void sleep_timeout(uint32_t data){
+    uint32_t flags;
+
+    // a sleeper that saw the timer pending holds the lock until it is on the queue
+    spin_lock_irqsave(&sleep_wq.lock, flags);
+    spin_unlock_irqrestore(&sleep_wq.lock, flags);
+    wq_wake_process((pcb_t*)data);
+}
+
+// suspends the calling process
+// Inputs: ms - how long to sleep, rounded up to whole PIT ticks
+// Outputs: returns success (0) or fail (-1) if ms is negative
+// Effects: the process is not scheduled until the time has passed
+int32_t sleep (int32_t ms){
+    uint32_t flags;
+    pcb_t *pcb = current_pcb();
+
+    if(pcb == NULL || ms < 0){
+        return -1;
+    }
+    uint32_t ticks = ((uint32_t)ms + MS_PER_TICK - 1) / MS_PER_TICK;
+    if(ticks == 0){
+        return 0;
+    }
+
+    spin_lock_irqsave(&sleep_wq.lock, flags);
+    pcb->sleep_timer.expires = pit_ticks + ticks;
+    pcb->sleep_timer.func = sleep_timeout;
+    pcb->sleep_timer.data = (uint32_t)pcb;
+    timer_add(&pcb->sleep_timer);
+    while(pcb->sleep_timer.pending && !pcb->killed){
+        wq_sleep(&sleep_wq);
+    }
+    spin_unlock_irqrestore(&sleep_wq.lock, flags);
+    // a killed process wakes up early, sleep_timeout takes sleep_wq.lock so
+    // the timer can only go once we have let go of it
+    timer_del(&pcb->sleep_timer);
+    return 0;
+}
+
+// grows or shrinks the heap of the calling process
+// Inputs: increment - number of bytes to add, negative to give memory back
+// Outputs: returns the old end of the heap or fail (-1)
+// Effects: new heap memory is zero-filled when it is first touched
+int32_t sbrk (int32_t increment){
+    pcb_t* pcb = current_pcb();
+    if(pcb == NULL){
+        return -1;
+    }
+    uint32_t old_brk = pcb->mm.brk;
+
+    if(user_mem_brk(&pcb->mm, old_brk + increment) == -1){
+        return -1;
+    }
+    return old_brk;
+}
+
 // returns failure since we don't have extra credit implemented yet
 int32_t set_handler (int32_t signum, void* handler_address){
     return -1;
@@ -411,6 +1110,48 @@ int32_t sigreturn (void){
     return -1;
 }
 
+// Get the pcb of a process
+// Inputs: pid - process id
+// Outputs: pointer to the pcb, NULL if there is no such process
+// Effects: none
+pcb_t* get_pcb(int32_t pid) {
+    if(pid < 0 || pid >= MAX_PIDS) {
+        return NULL;
+    }
+    return pcb_array[pid];
+}
+
+// Get the pcb of the process running on this CPU
+// Inputs: none
+// Outputs: pointer to the pcb, NULL while the CPU is idle
+// Effects: none
+pcb_t* current_pcb(void) {
+    return get_pcb(this_pid());
+}
+
+// Resolves a page fault in user memory
+// Inputs: addr - faulting address from CR2
+//         error_code - page fault error code pushed by the processor
+// Outputs: returns success (0) or fail (-1) if the access is not allowed
+// Effects: maps demand-zero pages and copies shared pages of the current process
+int32_t user_page_fault(uint32_t addr, uint32_t error_code) {
+    pcb_t* pcb = current_pcb();
+
+    if(pcb == NULL) {
+        return -1;
+    }
+    return user_mem_fault(&pcb->mm, addr, error_code);
+}
+
+// Creates the slab caches for per-process structures
+// Inputs: none
+// Outputs: none
+// Effects: must run after kmem_init
+void init_process_caches() {
+    pcb_cache = kmem_cache_create((int8_t*)"pcb", sizeof(pcb_t));
+    fd_cache = kmem_cache_create((int8_t*)"fd_array", sizeof(file_descriptor_t) * FILE_DESCRIPTOR_ARRAY_SIZE);
+}
+
 // Initializes our fops table
 // Inputs: none
 // Outputs: none
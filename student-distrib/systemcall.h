@@ -10,6 +10,21 @@
 #include "tests.h"
 #include "types.h"
 #include "rtc.h"
+#include "syscall_stats.h"
+#include "buddy.h"
+#include "slab.h"
+#include "user_mem.h"
+#include "schedule.h"
+#include "schedule_wrapper.h"
+#include "irq_stats.h"
+#include "bottom_half.h"
+#include "wait_queue.h"
+#include "timer.h"
+#include "fpu.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "clock.h"
+#include "sched_lat.h"
 
 #define NUM_DEVICES 6
 #define RTC_INDEX 0
@@ -17,27 +32,47 @@
 #define FILE_INDEX 2
 #define TERMINAL_INDEX 3
 #define FILE_DESCRIPTOR_ARRAY_SIZE 8
-#define MAX_OPEN_PROGS 6
+// size of the pid table, the real limit is how much memory there is
+#define MAX_PIDS 64
 #define EXCEPTION_HALT 111
 #define RET_EXCEPTION_HALT 256
 #define BUF_SIZE 128
-#define USR_IDX 32
 #define VID_IDX 34
 
+// statistics kstat can return
+#define KSTAT_KMEM 0
+#define KSTAT_TLB 1
+#define KSTAT_IRQ 2
+#define KSTAT_SCHED_LAT 3
+#define KSTAT_FAIR_SHARE 4
+
 // according to mp3 doc
 // "The EIP you need to jump to is the entry point from bytes 24-27 of the executable that you have just loaded"
 #define EIP_OFFSET 24
 #define EIP_BYTES 4
 
+// the rest of the ELF header is only read to find the end of the image
+#define ELF_HEADER_SIZE 52
+#define ELF_PHOFF_OFFSET 28
+#define ELF_PHNUM_OFFSET 44
+#define ELF_PHDR_SIZE 32
+#define ELF_PT_LOAD 1
+// words of a program header
+#define PHDR_TYPE 0
+#define PHDR_VADDR 2
+#define PHDR_MEMSZ 5
+
 #define FLAG_MASK 0x0200  
+// bit 1 of eflags always reads as 1
+#define EFLAGS_RESERVED 0x0002
 #define MEM_FENCE 4
-#define USER_START 0x08000000
-#define KEY_MEM 0x08400000 - MEM_FENCE    
+#define KEY_MEM USER_END - MEM_FENCE    
 #define USER_VID_MEM 0x08800000
 
-// choose sufficiently large buffer size
-// exact size doesn't really matter
-#define RAND_BUF_SIZE 42
+// every process gets an 8KB kernel stack
+#define KSTACK_ORDER ORDER_8KB
+#define KSTACK_SIZE EIGHTKB
+#define KSTACK_TOP(pcb) ((uint32_t)(pcb)->kernel_stack + KSTACK_SIZE - MEM_FENCE)
 
 // define ASCII codes
 #define ASCII_DEL 0x7F
@@ -45,33 +80,146 @@
 #define ASCII_L 0x4C
 #define ASCII_F 0x46
 
+// options for waitpid
+#define WNOHANG 1
+
+// process states
+#define PROC_NEW        0   // being set up, not ready to run
+#define PROC_RUNNABLE   1   // running or waiting for the CPU
+#define PROC_BLOCKED    2   // asleep on a wait queue
+#define PROC_ZOMBIE     3   // exited, parent has not collected the status yet
+#define PROC_DEAD       4   // exited without a parent, freed after switching away
+
+// terminal of kernel threads, they never enter user mode
+#define KTHREAD_TERMINAL -1
+
+// CPU time a process has used
+// ticks are PIT ticks that found the process running, cycles are TSC
+// cycles between switching to it and away from it
+typedef struct cpu_stats_t {
+    uint32_t user_ticks;
+    uint32_t kernel_ticks;
+    uint64_t cycles;
+    // switches because the process blocked or exited
+    uint32_t nvcsw;
+    // switches while it could have kept running, preemption and yield
+    uint32_t nivcsw;
+} cpu_stats_t;
+
+// one entry of what procstat returns
+#define PROC_NAME_LEN 33
+typedef struct proc_info_t {
+    int32_t pid;
+    int32_t parent_pid;
+    int32_t terminal;
+    uint32_t state;
+    int8_t name[PROC_NAME_LEN];
+    uint32_t user_ticks;
+    uint32_t kernel_ticks;
+    uint32_t cycles_lo;
+    uint32_t cycles_hi;
+    uint32_t nvcsw;
+    uint32_t nivcsw;
+    uint32_t priority;
+    uint32_t syscalls;
+    sched_lat_t sched_lat;
+} proc_info_t;
+
+// schedctl operations
+#define SCHED_GET 0
+#define SCHED_SET 1
+
+// pid of the idle task, procstat reports it first
+#define IDLE_PID -1
 
 // struct for pcb
 typedef struct pcb_t{
     // information for current process/task
     int32_t pid;
-    uint32_t program_esp;
-    uint32_t program_ebp;
+    uint8_t state;
+    // program name, or the name of a kernel thread
+    uint8_t name[PROC_NAME_LEN];
+    // terminal the process reads from and writes to
+    int32_t terminal;
 
-    // parent values for context switching
-    // will be used on execute and halt to know where to go
+    // process that collects our exit status, -1 if there is none
     int32_t parent_pid;
-    uint32_t parent_esp;
-    uint32_t parent_ebp;
-    
+    int32_t exit_status;
+    // set by ctrl + c, the process halts the next time it is scheduled
+    uint8_t killed;
+
+    // kernel stack pointer saved by context_switch while we are not running
+    uint32_t context_esp;
+    // next process on the run queue
+    struct pcb_t* run_next;
+    // CPU whose run queue we are on, and whether we are on that CPU right now
+    volatile uint32_t cpu;
+    volatile uint8_t on_cpu;
+    // MLFQ level, 0 is the highest, and ticks left of the current time slice
+    uint32_t priority;
+    uint32_t slice_left;
+    // when we last became runnable and on which CPU, for the latency tracer,
+    // wake_pending is set until we get the CPU
+    uint64_t wake_ns;
+    uint32_t wake_cpu;
+    uint8_t wake_pending;
+    // deadline scheduling, dl_period_us is 0 for a normal process
+    // the process may run dl_runtime more nanoseconds before dl_deadline,
+    // once it is used up it is throttled until dl_timer gives it a new period
+    uint32_t dl_period_us;
+    uint32_t dl_budget_us;
+    uint32_t dl_util;
+    uint64_t dl_deadline;
+    int64_t dl_runtime;
+    uint8_t dl_throttled;
+    ktimer_t dl_timer;
+
+    // wait queue we are blocked on, and the next process on it
+    wait_queue_t* wait_queue;
+    struct pcb_t* wait_next;
+    // where waitpid sleeps until one of our children exits
+    wait_queue_t child_wq;
+    // deadline of a sleep call
+    ktimer_t sleep_timer;
+
     // each program has its own set of files
-    file_descriptor_t systemcall_fd_array[FILE_DESCRIPTOR_ARRAY_SIZE];
+    // FILE_DESCRIPTOR_ARRAY_SIZE entries from the fd_array cache
+    file_descriptor_t* systemcall_fd_array;
     
-    // privilege info from TSS
-    uint32_t esp;
-    uint32_t ss;
+    // physical memory from the frame allocator
+    uint32_t kernel_stack;
+    // address space, loaded into CR3 whenever this process runs
+    page_directory_entry_t* page_dir;
+
+    // user pages, filled in on demand
+    user_mem_t mm;
+
+    // program image still to be loaded when the process first runs, -1 once it is
+    int32_t image_inode;
+    uint32_t image_size;
 
-    // arg buffer for get_args
-    uint8_t arg_buff[BUF_SIZE];
+    // arguments on the user stack, set up by execute
+    // argv is the user address of the NULL terminated pointer array
+    uint32_t argc;
+    uint32_t argv;
+
+    // system call counters and latency histograms for this process
+    syscall_stats_t syscall_stats;
+    // CPU time, kept by the scheduler
+    cpu_stats_t cpu_stats;
+    // how long we waited for the CPU after waking up
+    sched_lat_t sched_lat;
+    // saved FPU and SSE registers, NULL until the first FPU instruction
+    uint8_t* fpu_state;
+    // CPU we last used the FPU on
+    uint32_t fpu_cpu;
 } pcb_t;
 
-extern int32_t curr_pid;
-extern int32_t new_pid;
+// one per CPU, runs when nothing else is runnable there, not in the pid table
+extern pcb_t idle_tasks[NR_CPUS];
+
+// protects the pid table and the parent links between processes
+extern spinlock_t pid_lock;
 
 // functions needed for 3.3
 int32_t halt (uint8_t status);
@@ -84,10 +232,49 @@ int32_t getargs(uint8_t* buf, int32_t nbytes);
 int32_t vidmap (uint8_t** screen_start);
 int32_t set_handler (int32_t signum, void* handler_address);
 int32_t sigreturn (void);
+int32_t sysstat (int32_t pid, void* buf, int32_t nbytes);
+int32_t kstat (int32_t which, void* buf, int32_t nbytes);
+int32_t fork (void);
+int32_t sbrk (int32_t increment);
+int32_t waitpid (int32_t pid, int32_t* status, int32_t options);
+int32_t sleep (int32_t ms);
+int32_t yield (void);
+int32_t procstat (proc_info_t* buf, int32_t count);
+int32_t schedctl (int32_t op, void* buf, int32_t nbytes);
+int32_t clock_gettime (int32_t clock_id, timespec_t* ts);
+int32_t sched_deadline (int32_t period_us, int32_t budget_us);
+
+// returns the pcb of the process with the given pid
+extern pcb_t* get_pcb(int32_t pid);
+// returns the pcb of the process running on this CPU, NULL while it is idle
+extern pcb_t* current_pcb(void);
+
+// starts the shell of a terminal, returns its pid or -1
+extern int32_t start_shell(int32_t terminal);
+
+// creates a kernel thread running fn, it starts out in state PROC_NEW
+// returns its pcb, or NULL if there is no memory
+extern pcb_t* kthread_create(void (*fn)(void), const int8_t* name);
+
+// makes a process halt with USER_HALT, returns 0 or -1 if there is no such process
+extern int32_t process_kill(int32_t pid);
+// halts the running process if it was killed, called on the way back to user mode
+extern void process_kill_check(void);
+
+// frees a process that is not running anymore
+extern void process_release(pcb_t* pcb);
+
+// called by process_start before a new process enters user mode
+extern void process_entry();
+
+// resolves a page fault in the current process's user memory
+extern int32_t user_page_fault(uint32_t addr, uint32_t error_code);
 
 // Function to get the file operations table for a specific device
 extern fops_table_t* get_fops_table(int device_index);
 extern void init_fops_tables();
-fops_table_t fops_table[NUM_DEVICES];
+// creates the slab caches for pcbs and file arrays
+extern void init_process_caches();
+extern fops_table_t fops_table[NUM_DEVICES];
 #endif
 
@@ -1,7 +1,34 @@
 #ifndef _SYSTEMCALL_WRAPPER_H
 #define _SYSTEMCALL_WRAPPER_H
+
+// number of entries in the system call jump table
+#define NUM_SYSCALLS 21
+
 #ifndef ASM
+#include "types.h"
 
+// what the processor and systemcall_wrapper leave on the kernel stack
+// during a system call, from the lowest address up to the top of the stack
+typedef struct syscall_frame_t {
+    // arguments, also restored into the user's registers
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    // bookkeeping for syscall_stats
+    uint32_t tsc_lo;
+    uint32_t tsc_hi;
+    uint32_t index;
+    // callee-saved user registers
+    uint32_t edi;
+    uint32_t esi;
+    uint32_t ebp;
+    // pushed by the processor on int $0x80
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+    uint32_t esp;
+    uint32_t ss;
+} syscall_frame_t;
 
 // wrapper function for system calls
 extern void systemcall_wrapper();
@@ -1,8 +1,11 @@
 #include "terminal.h"
 
-volatile uint32_t read_flag = 0;
+volatile uint32_t read_flag[TERMINAL_COUNT];
 uint8_t terminal_buffer[BUF_SIZE];
-int32_t current_terminal, sched_terminal;
+int32_t current_terminal;
+terminal_t terminal_array[TERMINAL_COUNT];
+int32_t current_display;
+int32_t current_scheduled_process;
 
 /* int32_t terminal_open( const uint8_t* filename )
  *   Inputs: uint8_t* filename - not used
@@ -22,26 +25,32 @@ int32_t terminal_close( int32_t fd ) {
     return -1;
 }
 
-/* extern int32_t terminal_read( int32_t fd, void* buf, int32_t nbytes )
- *   Inputs: int32_t fd - not used
+/* extern int32_t terminal_read( struct file_descriptor_t* file, void* buf, int32_t nbytes )
+ *   Inputs: struct file_descriptor_t* file - not used
              void* buf  - buffer to read from
              int32_t nbytes - number of bytes to read from buffer
  *   Return Value: Number of bytes successfully read
  *   Effects: Copies keyboard buffer into terminal buffer
  *            It will need functionality from kb.h and kb.c */
-int32_t terminal_read( int32_t fd, void* buf, int32_t nbytes ){
+int32_t terminal_read( struct file_descriptor_t* file, void* buf, int32_t nbytes ){
+    // read from the terminal the process runs in, which may not be on screen
+    pcb_t *pcb = current_pcb();
+    int32_t t = (pcb == NULL) ? current_terminal : pcb->terminal;
+
     // just ensure the read_flag wasn't set improperly before
-    read_flag = 0;
+    read_flag[t] = 0;
 
     // used to count how many bytes read so far
     int ret_count = 0;
 
-    // wait for keyboard to detect an ENTER ('\n')
+    // sleep until the keyboard detects an ENTER ('\n')
     // then proceed with read
-    while(!read_flag){}
+    wait_event(&terminal_array[t].read_wq, read_flag[t]);
+    // killed while we waited, the process halts on its way back to user mode
+    if(!read_flag[t]) {return -1;}
 
     // reset read flag
-    read_flag = 0;
+    read_flag[t] = 0;
     // check if there's nothing to read from
     if(buf == NULL) {return 0;}
 
@@ -54,14 +63,17 @@ int32_t terminal_read( int32_t fd, void* buf, int32_t nbytes ){
     for(i = 0; i < BUF_SIZE; i++){
         temp_buf[i] = 0;
     }
-    for(i = 0; i < count[current_terminal]; i++){
-        temp_buf[i] = kb_buffer[current_terminal][i];
+    for(i = 0; i < count[t]; i++){
+        temp_buf[i] = kb_buffer[t][i];
         ret_count++;
         // break if we there is an ENTER
-        if(kb_buffer[current_terminal][i] == '\n'){ break; }
+        if(kb_buffer[t][i] == '\n'){ break; }
     }
     // clear keyboard buffer for next use
-    clear_buffer();
+    for(i = 0; i < count[t]; i++){
+        kb_buffer[t][i] = 0;
+    }
+    count[t] = 0;
     return ret_count;
 }
 
@@ -104,11 +116,22 @@ int32_t terminal_write( int32_t fd, const void* buf, int32_t nbytes ){
 void term_init(){
     int i;
     for(i = 0; i < TERMINAL_COUNT; i++){
-        terminal_array[i].terminal_current_pid = -1;
-        terminal_array[i].on_off_flag = terminal_array[i].terminal_esp = terminal_array[i].terminal_ebp = 0;
+        terminal_array[i].shell_pid = terminal_array[i].fg_pid = -1;
+        terminal_array[i].on_off_flag = 0;
+        read_flag[i] = 0;
+        wq_init(&terminal_array[i].read_wq);
     }
     current_terminal = 0;
-    sched_terminal = 0;
+}
+
+// points a terminal's user video memory at the screen or at its backing page
+// Inputs: terminal - terminal whose table to change
+//         on_screen - nonzero if the terminal is shown
+// Outputs: none
+static void set_vid_table(int32_t terminal, uint32_t on_screen){
+    page_table_entry_t pte = vid_tables[terminal][0];
+    pte.addy = on_screen ? VIDEO_START >> SHIFT_12 : (VIDEO_PAGES >> SHIFT_12) + terminal;
+    set_pte(vid_tables[terminal], USER_VID_MEM, pte);
 }
 
 // opens a particular terminal with given id
@@ -117,17 +140,41 @@ void term_init(){
 void open_terminal(int32_t terminal_id){
     // check for valid terminal_id
     // we don't need to do anything if the terminal is already open
+    uint32_t flags;
+
     if(terminal_id >= TERMINAL_COUNT || terminal_id < 0 || terminal_id == current_terminal){
         return;
     }
 
+    // move vidmap programs of the terminal on screen to its backing page and wait
+    // until no CPU has the screen cached for them, after that the screen only
+    // changes under console_lock
+    // tlb_shootdown must not be called holding console_lock, other CPUs may be
+    // spinning on it with interrupts off
+    // only the keyboard handler gets here, so current_terminal stays put in between
+    spin_lock_irqsave(&console_lock, flags);
+    set_vid_table(current_terminal, 0);
+    spin_unlock_irqrestore(&console_lock, flags);
+    tlb_shootdown(USER_VID_MEM);
+
+    // nobody may print while the screen changes hands
+    spin_lock_irqsave(&console_lock, flags);
     // store current screen of terminal
     memcpy((void*)(VIDEO_PAGES) + current_terminal * VID_MEM, (void*) VIDEO_START, VID_MEM);
     // change terminal to display
     current_terminal = terminal_id;
     // restore screen of correct terminal
     memcpy((void*)(VIDEO_START), (void*)(VIDEO_PAGES) + current_terminal * VID_MEM, VID_MEM);
+    set_vid_table(current_terminal, 1);
 
     // set cursor to the correct position in current terminal
     update_cursor(screen_x[current_terminal], screen_y[current_terminal]);
+    spin_unlock_irqrestore(&console_lock, flags);
+    // the new terminal's programs may still write to its backing page until this is done
+    tlb_shootdown(USER_VID_MEM);
+
+    // a terminal gets its shell the first time it is shown
+    if(!terminal_array[current_terminal].on_off_flag){
+        start_shell(current_terminal);
+    }
 }
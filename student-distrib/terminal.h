@@ -5,6 +5,7 @@
 #include "lib.h"
 #include "kb.h"
 #include "systemcall.h"
+#include "wait_queue.h"
 
 #define BUF_SIZE 128
 #define VID_MEM 0x1000
@@ -12,10 +13,10 @@
 #define VIDEO_START    0xB8000
 #define VIDEO_PAGES    0xBA000
 
-// check if keyboard is ready for read
+// check if keyboard is ready for read, one flag per terminal
 // this should usually be low
 // then set to high specifically after there is an ENTER ('\n') detected
-extern volatile uint32_t read_flag;
+extern volatile uint32_t read_flag[];
 
 extern uint8_t terminal_buffer[BUF_SIZE];
 
@@ -27,26 +28,29 @@ extern int32_t terminal_open( const uint8_t* filename );
 extern int32_t terminal_close( int32_t fd );
 
 // read from keyboard
-extern int32_t terminal_read( int32_t fd, void* buf, int32_t nbytes );
+struct file_descriptor_t;
+extern int32_t terminal_read( struct file_descriptor_t* file, void* buf, int32_t nbytes );
 
 // display the content from buffer to screen
 extern int32_t terminal_write( int32_t fd, const void* buf, int32_t nbytes );
 
 typedef struct terminal_t {
     uint8_t terminal_vidmem_buffer[BUF_SIZE];
-    int32_t terminal_current_pid;
-    uint32_t terminal_esp;
-    uint32_t terminal_ebp;
+    // pid of the terminal's shell, -1 until it is started
+    int32_t shell_pid;
+    // pid that ctrl + c kills, the program the shell is waiting for
+    int32_t fg_pid;
     int32_t on_off_flag;
+    // processes reading from the terminal sleep here until ENTER is pressed
+    wait_queue_t read_wq;
 } terminal_t;
 
 // array of our three open terminals
-terminal_t terminal_array[TERMINAL_COUNT];
-int32_t current_display;
-int32_t current_scheduled_process;
+extern terminal_t terminal_array[TERMINAL_COUNT];
+extern int32_t current_display;
+extern int32_t current_scheduled_process;
 
 extern int32_t current_terminal;
-extern int32_t sched_terminal;
 
 // initialize our three terminal structs
 extern void term_init();
@@ -5,6 +5,16 @@
 #include "kb.h"
 #include "terminal.h"
 #include "file_sys.h"
+#include "buddy.h"
+#include "slab.h"
+#include "paging.h"
+#include "i8259.h"
+#include "lapic.h"
+#include "ioapic.h"
+#include "clock.h"
+#include "user_mem.h"
+#include "smp.h"
+#include "spinlock.h"
 
 #define PASS 1
 #define FAIL 0
@@ -139,7 +149,7 @@ void test_terminal_all(){
 	while (1)
 	{
 		// take keyboard input
-		read_bytes = terminal_read(0, (void*) buffer, BUF_SIZE);		
+		read_bytes = terminal_read(NULL, (void*) buffer, BUF_SIZE);		
 
 		// print buffer to screen
 		write_bytes = terminal_write(0, (void*) buffer, read_bytes);
@@ -176,7 +186,7 @@ void test_terminal_write(){
 	int read_bytes, write_bytes;
 
 	// take keyboard input
-	read_bytes = terminal_read(0, (void*) buffer, BUF_SIZE);		
+	read_bytes = terminal_read(NULL, (void*) buffer, BUF_SIZE);		
 
 	// print buffer to screen
 	write_bytes = terminal_write(0, (void*) buffer, read_bytes - 3);
@@ -219,7 +229,7 @@ void rtc_test() {
         }
 		printf("\n Current rate: %d Hz. \n", rate);
         for (freq = 0; freq < rate; freq++) {
-            rtc_read(fd, NULL, 0);
+            rtc_read(NULL, NULL, 0);
             printf("1");
         }
 
@@ -232,10 +242,10 @@ void rtc_test() {
 // Input: none
 // Iutput: none
 void rtc_test2(){
-    int32_t fd = rtc_open((uint8_t*)"RTC");
+    rtc_open((uint8_t*)"RTC");
     // Opening sets the frequency to 2Hz
     while(1){
-        rtc_read(fd, NULL, 0);
+        rtc_read(NULL, NULL, 0);
         // Print '1' for each interrupt received
         printf("1");    
     }
@@ -267,6 +277,21 @@ void print_str(uint8_t* buf) {
     return;
 }
 
+// opens a file for the file system tests, the way the open system call would
+// Input: name - file to open, file - descriptor to fill in
+// Output: returns 0 or -1 if there is no such file
+static int32_t test_open_file(const uint8_t* name, file_descriptor_t* file) {
+    dentry_t dentry;
+
+    if (file_open(name) == -1 || read_dentry_by_name(name, &dentry) == -1) {
+        return -1;
+    }
+    file->inode = dentry.inode_num;
+    file->file_position = 0;
+    file->flags = OPEN;
+    return 0;
+}
+
 // Test case for opening large file with very long name
 // Input: none
 // Output: returns pass (1) or fail (-1)
@@ -277,15 +302,15 @@ int test_print_large_text () {
     uint32_t nbytes = DATA_BLOCK_SIZE*3;
     uint32_t bytes_read = 0;
 
-    uint32_t fd = file_open((const uint8_t*) test);
-    if (fd == -1) {
+    file_descriptor_t file;
+    if (test_open_file((const uint8_t*) test, &file) == -1) {
         return FAIL;
     }
 
-    bytes_read = file_read(fd, buf, nbytes);
+    bytes_read = file_read(&file, buf, nbytes);
     print_str(buf);
 
-    file_close(fd);
+    file_close(0);
     return PASS;
 
 }
@@ -300,15 +325,15 @@ int test_print_frame0_text () {
     uint32_t nbytes = DATA_BLOCK_SIZE*3;
     uint32_t bytes_read = 0;
 
-    uint32_t fd = file_open((const uint8_t*) test);
-    if (fd == -1) {
+    file_descriptor_t file;
+    if (test_open_file((const uint8_t*) test, &file) == -1) {
         return FAIL;
     }
 
-    bytes_read = file_read(fd, buf, nbytes);
+    bytes_read = file_read(&file, buf, nbytes);
     print_str(buf);
 
-    file_close(fd);
+    file_close(0);
     return PASS;
 
 }
@@ -326,14 +351,14 @@ int test_print_executable () {
     uint8_t buf[DATA_BLOCK_SIZE*3];
     uint32_t nbytes = 128;
     uint32_t nbytes_read = 0;
-    uint32_t fd = file_open((const uint8_t*) test);
+    file_descriptor_t file;
 
     // attempt to open the file, return fail if unsuccessful
-    if (fd == -1) {
+    if (test_open_file((const uint8_t*) test, &file) == -1) {
         return FAIL;
     }
     // store the number of bytes read
-    nbytes_read = file_read(fd, buf, nbytes);
+    nbytes_read = file_read(&file, buf, nbytes);
 
     // while there are bytes to read
     while (nbytes_read > 0) {
@@ -341,11 +366,11 @@ int test_print_executable () {
         // write the contents of the buf to the terminal
         terminal_write(0, buf, nbytes_read);
         // read bytes agian
-        nbytes_read = file_read(fd, buf, nbytes);
+        nbytes_read = file_read(&file, buf, nbytes);
     }
 	putc('\n');
     // close the file
-    file_close(fd);
+    file_close(0);
     return PASS;
 
 }
@@ -359,7 +384,7 @@ void test_directory_read () {
     uint8_t buf[MAX_NAME_LENGTH];
 	// only directory in our file system is called '.'
     char dir[] = ".";
-    int32_t test_fd = 0;
+    file_descriptor_t test_dir = {.inode = 0, .file_position = 0, .flags = OPEN};
 
 	// open directory
     clear_buffer();
@@ -369,7 +394,7 @@ void test_directory_read () {
     inode_t cur_inode;  
 
 	// print out each file in directory one at a time
-    while(dir_read(test_fd, buf, MAX_NAME_LENGTH) > 0) {
+    while(dir_read(&test_dir, buf, MAX_NAME_LENGTH) > 0) {
         printf("file_name: ");
         terminal_write(0, buf, MAX_NAME_LENGTH);
         read_dentry_by_name(buf, &cur_dentry);
@@ -378,7 +403,673 @@ void test_directory_read () {
         printf("\n");
     }
 
-    dir_close(test_fd);
+    dir_close(0);
+}
+
+/* Memory management tests */
+
+// Function: buddy_alloc_test
+// Description: allocates blocks of a few sizes, checks their alignment and
+//              that freeing them gives every page back
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None once the blocks are freed
+int buddy_alloc_test(){
+	TEST_HEADER;
+
+	int result = PASS;
+	uint32_t free_before = buddy_free_count();
+	uint32_t page = alloc_pages(ORDER_4KB);
+	uint32_t stack = alloc_pages(ORDER_8KB);
+	uint32_t large = alloc_pages(ORDER_4MB);
+
+	if(page == 0 || stack == 0 || large == 0){
+		result = FAIL;
+	}
+	if((page & (PAGE_SIZE - 1)) || (stack & (2 * PAGE_SIZE - 1)) || (large & (FOURMB - 1))){
+		result = FAIL;
+	}
+	if(page < ALLOC_START || stack < ALLOC_START || large < ALLOC_START){
+		result = FAIL;
+	}
+
+	free_pages(page, ORDER_4KB);
+	free_pages(stack, ORDER_8KB);
+	free_pages(large, ORDER_4MB);
+	if(buddy_free_count() != free_before){
+		result = FAIL;
+	}
+	return result;
+}
+
+// Function: kmalloc_test
+// Description: allocates from a slab size class and from the page path,
+//              checks alignment and that freed objects are reused
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None once the memory is freed
+int kmalloc_test(){
+	TEST_HEADER;
+
+	int result = PASS;
+	uint8_t* small = kmalloc(24);
+	uint8_t* large = kmalloc(3 * PAGE_SIZE);
+
+	if(small == NULL || large == NULL){
+		return FAIL;
+	}
+	if(((uint32_t)small & (KMEM_ALIGN - 1)) || ((uint32_t)large & (PAGE_SIZE - 1))){
+		result = FAIL;
+	}
+	memset(small, 0xAA, 24);
+	memset(large, 0xAA, 3 * PAGE_SIZE);
+
+	kfree(small);
+	// the most recently freed object is handed out first
+	if(kmalloc(32) != small){
+		result = FAIL;
+	}
+	kfree(small);
+	kfree(large);
+	return result;
+}
+
+// Function: kstat_buffer_test
+// Description: kstat and sysstat only write to buffers that lie entirely
+//              in user memory
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int kstat_buffer_test(){
+	TEST_HEADER;
+
+	static kmem_stat_t stats;
+
+	if(kstat(KSTAT_KMEM, &stats, sizeof(stats)) != -1 ||
+	   kstat(KSTAT_KMEM, (void*)(USER_END - 4), sizeof(stats)) != -1 ||
+	   sysstat(SYSSTAT_GLOBAL, &stats, sizeof(stats)) != -1 ||
+	   sysstat(SYSSTAT_GLOBAL, (void*)(USER_START - 4), 8) != -1){
+		return FAIL;
+	}
+	return PASS;
+}
+
+// Function: page_directory_test
+// Description: a new page directory shares the kernel's global entries,
+//              has no user mappings and can be loaded and unloaded
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: switches CR3 and back
+int page_directory_test(){
+	TEST_HEADER;
+
+	int result = PASS;
+	int i;
+	page_directory_entry_t* pd = new_page_directory();
+
+	if(pd == NULL){
+		return FAIL;
+	}
+	for(i = 0; i < ENTRIES; i++){
+		if(i < KERNEL_PDE_END && *(uint32_t*)&pd[i] != *(uint32_t*)&page_directory[i]){
+			result = FAIL;
+		}
+		if(i >= KERNEL_PDE_END && pd[i].present){
+			result = FAIL;
+		}
+	}
+	if(!pd[1].g){
+		result = FAIL;
+	}
+
+	// the kernel keeps running in the new address space
+	load_page_directory(pd);
+	load_page_directory(page_directory);
+	free_page_directory(pd);
+	return result;
+}
+
+// Function: user_mem_brk_test
+// Description: the heap starts on the page after the image and brk stays
+//              between the heap start and the stack range
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None once the address space is freed
+int user_mem_brk_test(){
+	TEST_HEADER;
+
+	int result = PASS;
+	user_mem_t mm;
+
+	if(user_mem_init(&mm, USER_IMAGE_START + 1) == -1){
+		return FAIL;
+	}
+	if(mm.heap_start != USER_IMAGE_START + PAGE_SIZE || mm.brk != mm.heap_start || mm.resident != 0){
+		result = FAIL;
+	}
+	if(user_mem_brk(&mm, mm.heap_start + 3 * PAGE_SIZE) != 0 || mm.brk != mm.heap_start + 3 * PAGE_SIZE){
+		result = FAIL;
+	}
+	if(user_mem_brk(&mm, mm.heap_start - 1) != -1 || user_mem_brk(&mm, USER_STACK_LIMIT + 1) != -1){
+		result = FAIL;
+	}
+	if(user_mem_brk(&mm, mm.heap_start) != 0){
+		result = FAIL;
+	}
+	user_mem_free(&mm);
+	return result;
+}
+
+// Function: user_mem_map_test
+// Description: execute maps the top stack page early to put argv there,
+//              the page starts out zeroed and is only mapped once
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None once the address space is freed
+int user_mem_map_test(){
+	TEST_HEADER;
+
+	int result = PASS;
+	user_mem_t mm;
+	uint32_t page;
+
+	if(user_mem_init(&mm, USER_IMAGE_START) == -1){
+		return FAIL;
+	}
+	page = user_mem_map(&mm, USER_END - PAGE_SIZE);
+	if(page == 0 || mm.resident != 1 || *(uint32_t*)(page + PAGE_SIZE - sizeof(uint32_t)) != 0){
+		result = FAIL;
+	}
+	if(page != 0 && (user_mem_map(&mm, USER_END - 1) != page || mm.resident != 1)){
+		result = FAIL;
+	}
+	user_mem_free(&mm);
+	return result;
+}
+
+// counts how often bh_count_work ran
+static uint32_t bh_test_count;
+
+// work item for bottom_half_test
+static void bh_count_work(uint32_t data){
+	bh_test_count += data;
+}
+
+// Function: bottom_half_test
+// Description: the work queue holds BH_QUEUE_SIZE - 1 entries, and the
+//              worker runs all of them once it is scheduled
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: switches to the worker thread and back
+int bottom_half_test(){
+	TEST_HEADER;
+
+	int result = PASS;
+	int i;
+
+	bh_test_count = 0;
+	for(i = 0; i < BH_QUEUE_SIZE - 1; i++){
+		if(bh_queue(bh_count_work, 1) != 0){
+			result = FAIL;
+		}
+	}
+	if(bh_queue(bh_count_work, 1) != -1){
+		result = FAIL;
+	}
+	schedule();
+	if(bh_test_count != BH_QUEUE_SIZE - 1){
+		result = FAIL;
+	}
+	return result;
+}
+
+// Function: wait_queue_test
+// Description: waking one process unlinks just that one, waking everyone
+//              empties the queue and makes every sleeper runnable
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int wait_queue_test(){
+	TEST_HEADER;
+
+	static pcb_t a, b;
+	wait_queue_t wq;
+	int result = PASS;
+
+	// put two sleepers on the queue the way wq_sleep would
+	wq_init(&wq);
+	wq.head = &a;
+	wq.tail = &b;
+	a.wait_next = &b;
+	b.wait_next = NULL;
+	a.wait_queue = b.wait_queue = &wq;
+	a.state = b.state = PROC_BLOCKED;
+
+	wq_wake_process(&b);
+	if(b.state != PROC_RUNNABLE || b.wait_queue != NULL || wq.head != &a || wq.tail != &a || a.state != PROC_BLOCKED){
+		result = FAIL;
+	}
+	wq_wake_all(&wq);
+	if(a.state != PROC_RUNNABLE || a.wait_queue != NULL || wq.head != NULL || wq.tail != NULL){
+		result = FAIL;
+	}
+	return result;
+}
+
+// counts how often timer_test_func ran
+static uint32_t timer_test_fired;
+
+// timer callback for timer_test
+static void timer_test_func(uint32_t data){
+	timer_test_fired += data;
+}
+
+// Function: timer_test
+// Description: timers fire in order of expiry on the tick they expire,
+//              a deleted timer never fires
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: advances pit_ticks by two
+int timer_test(){
+	TEST_HEADER;
+
+	ktimer_t early, late, gone;
+	uint32_t flags;
+	int result = PASS;
+
+	// the PIT must not tick in the middle of the test
+	cli_and_save(flags);
+	timer_test_fired = 0;
+	late.expires = pit_ticks + 2;
+	early.expires = gone.expires = pit_ticks + 1;
+	late.func = early.func = gone.func = timer_test_func;
+	early.data = 1;
+	late.data = 10;
+	gone.data = 100;
+	late.pending = early.pending = gone.pending = 0;
+	timer_add(&late);
+	timer_add(&early);
+	timer_add(&gone);
+	timer_del(&gone);
+
+	timer_tick();
+	if(timer_test_fired != 1 || early.pending || !late.pending){
+		result = FAIL;
+	}
+	timer_tick();
+	if(timer_test_fired != 11 || late.pending || gone.pending){
+		result = FAIL;
+	}
+	restore_flags(flags);
+	return result;
+}
+
+// Function: timer_advance_test
+// Description: the tickless idle finds the next deadline and catching up
+//              several ticks at once fires every timer that came due
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: advances pit_ticks by three
+int timer_advance_test(){
+	TEST_HEADER;
+
+	ktimer_t first, second, later;
+	uint32_t flags, expires;
+	int result = PASS;
+
+	cli_and_save(flags);
+	timer_test_fired = 0;
+	first.expires = pit_ticks + 1;
+	second.expires = pit_ticks + 3;
+	later.expires = pit_ticks + 4;
+	first.func = second.func = later.func = timer_test_func;
+	first.data = 1;
+	second.data = 10;
+	later.data = 100;
+	first.pending = second.pending = later.pending = 0;
+	timer_add(&later);
+	timer_add(&second);
+	timer_add(&first);
+
+	if(timer_next_expiry(&expires) != 0 || expires != first.expires){
+		result = FAIL;
+	}
+	timer_advance(3);
+	if(timer_test_fired != 11 || !later.pending){
+		result = FAIL;
+	}
+	if(timer_next_expiry(&expires) != 0 || expires != later.expires){
+		result = FAIL;
+	}
+	timer_del(&later);
+	restore_flags(flags);
+	return result;
+}
+
+// Function: fpu_lazy_test
+// Description: the FPU is on, but the kernel runs with CR0.TS set so the
+//              first FPU instruction of a process traps into the #NM handler
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int fpu_lazy_test(){
+	TEST_HEADER;
+
+	uint32_t cr0;
+
+	asm volatile("movl %%cr0, %0" : "=r"(cr0));
+	if((cr0 & (CR0_EM | CR0_TS | CR0_MP)) != (CR0_TS | CR0_MP)){
+		return FAIL;
+	}
+	return (idle_tasks[0].fpu_state == NULL) ? PASS : FAIL;
+}
+
+// Function: procstat_test
+// Description: procstat only writes to user buffers, and the kernel worker
+//              thread it reports has a name and no terminal
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int procstat_test(){
+	TEST_HEADER;
+
+	static proc_info_t info[2];
+	pcb_t* pcb;
+	int32_t i;
+
+	if(procstat(NULL, 2) != -1 || procstat(info, 2) != -1){
+		return FAIL;
+	}
+	for(i = 0; i < MAX_PIDS; i++){
+		pcb = get_pcb(i);
+		if(pcb != NULL && pcb->terminal == KTHREAD_TERMINAL && strncmp((int8_t*)pcb->name, "kworker", 8) == 0){
+			return PASS;
+		}
+	}
+	return FAIL;
+}
+
+// Function: process_idle_test
+// Description: before the first shell starts the boot context is the idle
+//              task, there is no process to wait or yield in and schedule
+//              comes back to idle once the worker thread blocks
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int process_idle_test(){
+	TEST_HEADER;
+
+	int32_t status;
+
+	if(this_pid() != -1 || current_pcb() != NULL || idle_tasks[0].pid != IDLE_PID){
+		return FAIL;
+	}
+	if(waitpid(-1, &status, WNOHANG) != -1 || waitpid(-1, &status, 0) != -1 || yield() != -1){
+		return FAIL;
+	}
+	schedule();
+	return (this_pid() == -1) ? PASS : FAIL;
+}
+
+// Function: mlfq_tunables_test
+// Description: the scheduler starts with the default tunables and rejects
+//              a zero quantum or an io boost past the lowest level
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int mlfq_tunables_test(){
+	TEST_HEADER;
+
+	sched_tunables_t tunables = {.quantum = MLFQ_DEFAULT_QUANTA};
+	int32_t i;
+
+	for(i = 0; i < MLFQ_LEVELS; i++){
+		if(sched_tunables.quantum[i] != tunables.quantum[i]){
+			return FAIL;
+		}
+	}
+	tunables.boost_interval = MLFQ_DEFAULT_BOOST;
+	tunables.io_boost = MLFQ_LEVELS;
+	if(sched_set_tunables(&tunables) != -1){
+		return FAIL;
+	}
+	tunables.io_boost = MLFQ_DEFAULT_IO_BOOST;
+	tunables.quantum[MLFQ_LEVELS - 1] = 0;
+	if(sched_set_tunables(&tunables) != -1 || sched_tunables.quantum[MLFQ_LEVELS - 1] == 0){
+		return FAIL;
+	}
+	if(schedctl(SCHED_GET, &tunables, sizeof(tunables)) != -1){
+		return FAIL;
+	}
+	return PASS;
+}
+
+// Function: smp_test
+// Description: a lock can only be taken once until it is released, and the
+//              boot CPU finds itself as CPU 0 with no process running
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int smp_test(){
+	TEST_HEADER;
+
+	spinlock_t lock = SPINLOCK_INIT;
+	int result = PASS;
+
+	if(!spin_trylock(&lock) || spin_trylock(&lock)){
+		result = FAIL;
+	}
+	spin_unlock(&lock);
+	if(!spin_trylock(&lock)){
+		result = FAIL;
+	}
+	spin_unlock(&lock);
+	if(this_cpu() != &cpus[0] || this_cpu()->id != 0 || this_pid() != -1 || nr_cpus < 1 || nr_cpus > NR_CPUS){
+		result = FAIL;
+	}
+	return result;
+}
+
+// Function: apic_test
+// Description: once the I/O APIC has the interrupts the 8259 has every IRQ
+//              masked and they are sent to the local APIC of the boot CPU
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int apic_test(){
+	TEST_HEADER;
+
+	if(!ioapic_active){
+		return PASS;
+	}
+	if(inb(MASTER_PORT) != 0xFF || inb(SLAVE_PORT) != 0xFF || cpus[0].apic_id != lapic_id()){
+		return FAIL;
+	}
+	return PASS;
+}
+
+// Function: clock_test
+// Description: the clock moves forward by about one tick while PIT channel 2
+//              counts one down, and clock_gettime turns down a bad clock or buffer
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: busy waits one tick with interrupts off
+int clock_test(){
+	TEST_HEADER;
+
+	uint32_t flags;
+	uint64_t start, end;
+	timespec_t ts;
+
+	if(clock_gettime(CLOCK_MONOTONIC + 1, (timespec_t*)USER_START) != -1 ||
+	   clock_gettime(CLOCK_MONOTONIC, &ts) != -1){
+		return FAIL;
+	}
+	// counting PIT ticks is all we can do without the TSC
+	if(time_page->tsc_per_tick == 0){
+		return PASS;
+	}
+	cli_and_save(flags);
+	start = clock_ns();
+	pit_ch2_start(COUNT);
+	pit_ch2_wait();
+	end = clock_ns();
+	restore_flags(flags);
+	if(end <= start || end - start < NS_PER_TICK / 10 * 9 || end - start > NS_PER_TICK * 2){
+		return FAIL;
+	}
+	ns_to_timespec(end, &ts);
+	if(ts.nsec >= NS_PER_SEC){
+		return FAIL;
+	}
+	return PASS;
+}
+
+// Function: time_page_test
+// Description: a new address space has the time page mapped read-only for
+//              users, and the page has the current tick count in it
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int time_page_test(){
+	TEST_HEADER;
+
+	uint32_t flags;
+	int result = PASS;
+	page_directory_entry_t* pd = new_page_directory();
+
+	if(pd == NULL){
+		return FAIL;
+	}
+	if(!pd[TIME_IDX].present || !pd[TIME_IDX].us || pd[TIME_IDX].ps ||
+	   (pd[TIME_IDX].addy << SHIFT_12) != (uint32_t)time_table ||
+	   !time_table[0].present || !time_table[0].us || time_table[0].rw){
+		result = FAIL;
+	}
+	cli_and_save(flags);
+	if(time_page->ticks != pit_ticks){
+		result = FAIL;
+	}
+	restore_flags(flags);
+	free_page_directory(pd);
+	return result;
+}
+
+// Function: sched_lat_test
+// Description: a process that waited about 5 ms for the CPU after waking
+//              up lands in the 4-8 ms bucket of its own and the global
+//              histogram, and is the worst trace if nothing waited longer
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: adds one sample to the global numbers
+int sched_lat_test(){
+	TEST_HEADER;
+
+	static pcb_t pcb;
+	uint32_t flags, before;
+	sched_lat_report_t report;
+	int result = PASS;
+
+	memset(&pcb, 0, sizeof(pcb));
+	pcb.pid = IDLE_PID - 1;
+	strcpy((int8_t*)pcb.name, "sched_lat_test");
+	sched_lat_get(&report);
+	before = report.all.hist[12];
+
+	cli_and_save(flags);
+	sched_lat_wake(&pcb);
+	pcb.wake_ns -= 5000 * NS_PER_US;
+	sched_lat_run(&idle_tasks[0], &pcb);
+	// only a new wakeup counts again
+	sched_lat_run(&idle_tasks[0], &pcb);
+	restore_flags(flags);
+
+	sched_lat_get(&report);
+	if(pcb.wake_pending || pcb.sched_lat.count != 1 || pcb.sched_lat.hist[12] != 1 ||
+	   pcb.sched_lat.max_us < 5000 || report.all.hist[12] != before + 1){
+		result = FAIL;
+	}
+	if(report.worst[0].latency_us == pcb.sched_lat.max_us &&
+	   (report.worst[0].pid != pcb.pid || report.worst[0].prev_pid != IDLE_PID)){
+		result = FAIL;
+	}
+	return result;
+}
+
+// Function: deadline_test
+// Description: sched_set_deadline turns down reservations that are out of
+//              range or fit on no CPU, and gives back what it admitted when
+//              the process becomes a normal one again
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None
+int deadline_test(){
+	TEST_HEADER;
+
+	static pcb_t pcb;
+	int result = PASS;
+
+	// on no run queue, so nothing schedules it while it is a deadline process
+	memset(&pcb, 0, sizeof(pcb));
+	pcb.pid = IDLE_PID - 1;
+	pcb.cpu = 0;
+
+	if(sched_set_deadline(&pcb, DL_MAX_PERIOD_US + 1, DL_MIN_BUDGET_US) != -1 ||
+	   sched_set_deadline(&pcb, 1000, DL_MIN_BUDGET_US - 1) != -1 ||
+	   sched_set_deadline(&pcb, 1000, 1001) != -1 ||
+	   // 95% of a CPU fits on none of them
+	   sched_set_deadline(&pcb, 1000, 950) != -1 || pcb.dl_util != 0){
+		result = FAIL;
+	}
+
+	// 89% fits on an idle CPU 0 only if the first reservation was given back
+	if(sched_set_deadline(&pcb, 1000, 100) != 0 || pcb.dl_util == 0 ||
+	   pcb.dl_runtime != 100 * NS_PER_US || pcb.dl_throttled ||
+	   sched_set_deadline(&pcb, 0, 0) != 0 || pcb.dl_period_us != 0 || pcb.dl_util != 0 ||
+	   sched_set_deadline(&pcb, 1000, 890) != 0 || pcb.cpu != 0 ||
+	   sched_set_deadline(&pcb, 0, 0) != 0){
+		result = FAIL;
+	}
+	return result;
+}
+
+// Function: fair_share_test
+// Description: every terminal's group starts with the default share, shares
+//              out of range are turned down and a new one shows up in kstat
+// Inputs: None
+// Outputs: PASS/FAIL
+// Effects: None, the old tunables are put back
+int fair_share_test(){
+	TEST_HEADER;
+
+	sched_tunables_t old = sched_tunables, tunables = sched_tunables;
+	fair_stat_t stats[FAIR_GROUPS];
+	int result = PASS;
+	int32_t i;
+
+	for(i = 0; i < FAIR_GROUPS; i++){
+		if(sched_tunables.share[i] != FAIR_DEFAULT_SHARE){
+			result = FAIL;
+		}
+	}
+	tunables.share[0] = 0;
+	if(sched_set_tunables(&tunables) != -1){
+		result = FAIL;
+	}
+	tunables.share[0] = FAIR_MAX_SHARE + 1;
+	if(sched_set_tunables(&tunables) != -1){
+		result = FAIL;
+	}
+	tunables.share[0] = 2 * FAIR_DEFAULT_SHARE;
+	if(sched_set_tunables(&tunables) != 0){
+		result = FAIL;
+	}
+	sched_fair_get(stats);
+	if(stats[0].share != 2 * FAIR_DEFAULT_SHARE || stats[1].share != FAIR_DEFAULT_SHARE){
+		result = FAIL;
+	}
+	sched_set_tunables(&old);
+	return result;
 }
 
 /* Checkpoint 3 tests */
@@ -412,4 +1103,27 @@ void launch_tests(){
 	// TEST_OUTPUT("test_print_frame0_text", test_print_frame0_text());
 	// TEST_OUTPUT("test_print_executable", test_print_executable());
 	// test_directory_read();
+
+	// memory management tests________________________________________________________________________
+	// TEST_OUTPUT("buddy_alloc_test", buddy_alloc_test());
+	// TEST_OUTPUT("kmalloc_test", kmalloc_test());
+	// TEST_OUTPUT("kstat_buffer_test", kstat_buffer_test());
+	// TEST_OUTPUT("page_directory_test", page_directory_test());
+	// TEST_OUTPUT("user_mem_brk_test", user_mem_brk_test());
+	// TEST_OUTPUT("user_mem_map_test", user_mem_map_test());
+	// TEST_OUTPUT("process_idle_test", process_idle_test());
+	// TEST_OUTPUT("bottom_half_test", bottom_half_test());
+	// TEST_OUTPUT("wait_queue_test", wait_queue_test());
+	// TEST_OUTPUT("timer_test", timer_test());
+	// TEST_OUTPUT("timer_advance_test", timer_advance_test());
+	// TEST_OUTPUT("procstat_test", procstat_test());
+	// TEST_OUTPUT("fpu_lazy_test", fpu_lazy_test());
+	// TEST_OUTPUT("mlfq_tunables_test", mlfq_tunables_test());
+	// TEST_OUTPUT("smp_test", smp_test());
+	// TEST_OUTPUT("apic_test", apic_test());
+	// TEST_OUTPUT("clock_test", clock_test());
+	// TEST_OUTPUT("time_page_test", time_page_test());
+	// TEST_OUTPUT("sched_lat_test", sched_lat_test());
+	// TEST_OUTPUT("deadline_test", deadline_test());
+	// TEST_OUTPUT("fair_share_test", fair_share_test());
 }
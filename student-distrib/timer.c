@@ -0,0 +1,122 @@
+// kernel timers
+// pending timers sit on one list sorted by expiry, so a tick only has to
+// look at the front of it
+
+#include "timer.h"
+#include "lib.h"
+#include "spinlock.h"
+#include "clock.h"
+
+volatile uint32_t pit_ticks;
+
+// pending timers, earliest first
+static ktimer_t* timer_list;
+// protects timer_list and the timers on it
+static spinlock_t timer_lock = SPINLOCK_INIT;
+// timer whose func CPU 0 is running right now, with timer_lock dropped
+static ktimer_t* volatile timer_running;
+
+// Description: compares two tick counts, even across a wrap of the counter
+// Inputs: a, b - tick counts less than 2^31 ticks apart
+// Outputs: nonzero if a comes before b
+// Effects: none
+static int32_t tick_before(uint32_t a, uint32_t b){
+    return (int32_t)(a - b) < 0;
+}
+
+// Description: takes a timer off the list
+// Inputs: timer - timer to take off
+// Outputs: none
+// Effects: timer_lock must be held
+static void timer_unlink(ktimer_t* timer){
+    ktimer_t** link;
+
+    if(timer->pending){
+        for(link = &timer_list; *link != timer; link = &(*link)->next);
+        *link = timer->next;
+        timer->pending = 0;
+    }
+}
+
+// Description: arms a timer
+// Inputs: timer - timer with expires, func and data set
+// Outputs: none
+// Effects: func runs from the PIT interrupt on the first tick at or after expires
+void timer_add(ktimer_t* timer){
+    uint32_t flags;
+    ktimer_t** link;
+
+    spin_lock_irqsave(&timer_lock, flags);
+    timer_unlink(timer);
+    // timers with the same expiry run in the order they were added
+    for(link = &timer_list; *link != NULL && !tick_before(timer->expires, (*link)->expires); link = &(*link)->next);
+    timer->next = *link;
+    *link = timer;
+    timer->pending = 1;
+    spin_unlock_irqrestore(&timer_lock, flags);
+}
+
+// Description: disarms a timer
+// Inputs: timer - timer to take off the list
+// Outputs: none
+// Effects: none if the timer already expired, if its func is running on
+//          another CPU we wait for it, so the timer can be freed afterwards
+void timer_del(ktimer_t* timer){
+    uint32_t flags;
+
+    spin_lock_irqsave(&timer_lock, flags);
+    timer_unlink(timer);
+    spin_unlock_irqrestore(&timer_lock, flags);
+    while(timer_running == timer){
+        asm volatile("pause");
+    }
+}
+
+// Description: handles one PIT tick
+// Inputs: none
+// Outputs: none
+// Effects: runs and removes every expired timer, called with interrupts off
+void timer_tick(void){
+    timer_advance(1);
+}
+
+// Description: counts several PIT ticks at once
+// Inputs: ticks - ticks that passed since the last call
+// Outputs: none
+// Effects: runs and removes every expired timer, called with interrupts off
+//          funcs run without timer_lock, they may add timers
+void timer_advance(uint32_t ticks){
+    ktimer_t* timer;
+
+    spin_lock(&timer_lock);
+    pit_ticks += ticks;
+    clock_tick();
+    while(timer_list != NULL && !tick_before(pit_ticks, timer_list->expires)){
+        timer = timer_list;
+        timer_list = timer->next;
+        timer->pending = 0;
+        timer_running = timer;
+        spin_unlock(&timer_lock);
+        timer->func(timer->data);
+        spin_lock(&timer_lock);
+        timer_running = NULL;
+    }
+    spin_unlock(&timer_lock);
+}
+
+// Description: finds when the next timer expires
+// Inputs: expires - where to store the expiry in PIT ticks
+// Outputs: 0, or -1 if no timer is pending
+// Effects: none
+int32_t timer_next_expiry(uint32_t* expires){
+    uint32_t flags;
+    int32_t ret = -1;
+
+    spin_lock_irqsave(&timer_lock, flags);
+    if(timer_list != NULL){
+        *expires = timer_list->expires;
+        ret = 0;
+    }
+    spin_unlock_irqrestore(&timer_lock, flags);
+    return ret;
+}
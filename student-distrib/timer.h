@@ -0,0 +1,45 @@
+// kernel timer header file
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include "types.h"
+
+// PIT interrupts per second, PIT_init sets the counter to match
+#define PIT_HZ 50
+// length of one PIT tick
+#define MS_PER_TICK (1000 / PIT_HZ)
+
+// runs from the PIT interrupt, must be short and must not sleep
+typedef void (*timer_func_t)(uint32_t data);
+
+// a deadline in PIT ticks, kept on a list sorted by expiry
+typedef struct ktimer_t {
+    uint32_t expires;
+    timer_func_t func;
+    uint32_t data;
+    // on the list until it expires or is deleted
+    uint8_t pending;
+    struct ktimer_t* next;
+} ktimer_t;
+
+// PIT ticks since boot, with a tickless idle it stands still while the
+// system is idle and no timer is pending
+extern volatile uint32_t pit_ticks;
+
+// arms a timer, its expires, func and data must be set
+extern void timer_add(ktimer_t* timer);
+
+// disarms a timer, does nothing if it is not pending
+extern void timer_del(ktimer_t* timer);
+
+// counts a tick and runs every timer that expired, called by pit_irq_handler
+extern void timer_tick(void);
+
+// counts several ticks at once, for ticks the idle task slept through,
+// and publishes the count in the time page
+extern void timer_advance(uint32_t ticks);
+
+// gets the expiry of the earliest pending timer, returns 0 or -1 if there is none
+extern int32_t timer_next_expiry(uint32_t* expires);
+
+#endif /* _TIMER_H */
@@ -0,0 +1,229 @@
+// user address spaces
+// every process has one page table behind USER_PDE_IDX, its pages are
+// allocated on first touch and shared copy-on-write after fork
+
+#include "user_mem.h"
+#include "lib.h"
+
+// index of the page table entry that maps addr
+#define USER_PTE_IDX(addr) (((addr) - USER_START) >> PAGE_SHIFT)
+
+// makes checking a shared page's refcount and acting on it atomic against
+// other address spaces taking or dropping references to the same page
+static spinlock_t cow_lock = SPINLOCK_INIT;
+
+// Description: sets up an empty address space
+// Inputs: mm - address space to set up
+//         image_end - first address past the program image, the heap starts
+//                     at the next page boundary
+// Outputs: 0 on success, -1 if there is no memory for the page table
+// Effects: nothing is mapped until it is touched
+int32_t user_mem_init(user_mem_t* mm, uint32_t image_end){
+    mm->table = (page_table_entry_t*)alloc_pages(ORDER_4KB);
+    if(mm->table == NULL){
+        return -1;
+    }
+    memset(mm->table, 0, sizeof(page_table_entry_t) * ENTRIES);
+    mm->heap_start = mm->brk = PAGE_ALIGN_UP(image_end);
+    mm->resident = 0;
+    spin_init(&mm->lock);
+    return 0;
+}
+
+// Description: frees an address space
+// Inputs: mm - address space to free, must not be loaded
+// Outputs: none
+// Effects: pages shared after fork are only freed with their last user
+void user_mem_free(user_mem_t* mm){
+    uint32_t i, flags;
+
+    if(mm->table == NULL){
+        return;
+    }
+    spin_lock_irqsave(&cow_lock, flags);
+    for(i = 0; i < ENTRIES; i++){
+        if(mm->table[i].present){
+            put_pages(mm->table[i].addy << SHIFT_12, ORDER_4KB);
+        }
+    }
+    spin_unlock_irqrestore(&cow_lock, flags);
+    free_pages((uint32_t)mm->table, ORDER_4KB);
+    mm->table = NULL;
+    mm->resident = 0;
+}
+
+// Description: points the user entry of a page directory at an address space
+// Inputs: mm - address space to map
+//         pd - page directory to change
+// Outputs: none
+// Effects: changes pd[USER_PDE_IDX]
+void user_mem_install(user_mem_t* mm, page_directory_entry_t* pd){
+    page_directory_entry_t pde = pd[USER_PDE_IDX];
+
+    pde.present = pde.rw = pde.us = 1;
+    // protection is decided per page, and user pages are never global
+    pde.ps = pde.g = 0;
+    pde.pwt = pde.pcd = pde.acc = pde.avl = pde.avl_3 = 0;
+    pde.addy = (uint32_t)mm->table >> SHIFT_12;
+    set_pde(pd, USER_PDE_IDX, pde);
+}
+
+// Description: makes a copy-on-write copy of an address space
+// Inputs: child - address space to set up
+//         parent - address space to copy, must be the loaded one
+// Outputs: 0 on success, -1 if there is no memory for the page table
+// Effects: every writable page of parent becomes read-only and shared
+int32_t user_mem_fork(user_mem_t* child, user_mem_t* parent){
+    page_table_entry_t pte;
+    uint32_t i, flags;
+
+    if(user_mem_init(child, parent->heap_start) == -1){
+        return -1;
+    }
+    child->brk = parent->brk;
+
+    // child is not visible to anyone else yet
+    spin_lock_irqsave(&parent->lock, flags);
+    spin_lock(&cow_lock);
+    for(i = 0; i < ENTRIES; i++){
+        pte = parent->table[i];
+        if(!pte.present){
+            continue;
+        }
+        if(pte.rw){
+            pte.rw = 0;
+            pte.avl_3 |= PTE_COW;
+            parent->table[i] = pte;
+        }
+        child->table[i] = pte;
+        get_pages(pte.addy << SHIFT_12);
+        child->resident++;
+    }
+    spin_unlock(&cow_lock);
+    spin_unlock_irqrestore(&parent->lock, flags);
+
+    // most of the parent's entries changed, one flush is cheaper than an invlpg each
+    flush_tlb();
+    return 0;
+}
+
+// Description: maps a zero-filled page before the process touches it
+// Inputs: mm - address space to change, must not be loaded
+//         addr - user address inside the page
+// Outputs: address the kernel can fill the page through, 0 if there is no memory
+// Effects: the page counts as resident like a faulted-in one
+uint32_t user_mem_map(user_mem_t* mm, uint32_t addr){
+    page_table_entry_t* pte;
+    uint32_t page, flags;
+
+    spin_lock_irqsave(&mm->lock, flags);
+    pte = &mm->table[USER_PTE_IDX(addr)];
+    if(pte->present){
+        page = pte->addy << SHIFT_12;
+        spin_unlock_irqrestore(&mm->lock, flags);
+        return page;
+    }
+    page = alloc_pages(ORDER_4KB);
+    if(page == 0){
+        spin_unlock_irqrestore(&mm->lock, flags);
+        return 0;
+    }
+    memset((void*)page, 0, PAGE_SIZE);
+    memset(pte, 0, sizeof(*pte));
+    pte->present = pte->rw = pte->us = 1;
+    pte->addy = page >> SHIFT_12;
+    mm->resident++;
+    spin_unlock_irqrestore(&mm->lock, flags);
+    return page;
+}
+
+// Description: handles a page fault in user space
+// Inputs: mm - the loaded address space
+//         addr - faulting address from CR2
+//         error_code - page fault error code pushed by the processor
+// Outputs: 0 if the access can be retried, -1 if it is a real fault
+// Effects: maps a zero-filled page on the first touch of the image, heap or stack,
+//          gives the process its own copy of a shared page on the first write
+int32_t user_mem_fault(user_mem_t* mm, uint32_t addr, uint32_t error_code){
+    page_table_entry_t pte;
+    uint32_t page, copy, flags;
+
+    if(mm->table == NULL || addr < USER_START || addr >= USER_END){
+        return -1;
+    }
+
+    spin_lock_irqsave(&mm->lock, flags);
+    pte = mm->table[USER_PTE_IDX(addr)];
+    if(!(error_code & PF_PRESENT)){
+        // only the image, the heap below brk and the stack are backed
+        if(!((addr >= USER_IMAGE_START && addr < mm->brk) || addr >= USER_STACK_LIMIT)){
+            spin_unlock_irqrestore(&mm->lock, flags);
+            return -1;
+        }
+        page = alloc_pages(ORDER_4KB);
+        if(page == 0){
+            spin_unlock_irqrestore(&mm->lock, flags);
+            return -1;
+        }
+        memset((void*)page, 0, PAGE_SIZE);
+        memset(&pte, 0, sizeof(pte));
+        pte.present = pte.rw = pte.us = 1;
+        pte.addy = page >> SHIFT_12;
+        mm->resident++;
+    } else if((error_code & PF_WRITE) && (pte.avl_3 & PTE_COW)){
+        page = pte.addy << SHIFT_12;
+        spin_lock(&cow_lock);
+        // nobody else has the page anymore, so it can just be made writable
+        if(page_refcount(page) > 1){
+            copy = alloc_pages(ORDER_4KB);
+            if(copy == 0){
+                spin_unlock(&cow_lock);
+                spin_unlock_irqrestore(&mm->lock, flags);
+                return -1;
+            }
+            memcpy((void*)copy, (void*)page, PAGE_SIZE);
+            put_pages(page, ORDER_4KB);
+            pte.addy = copy >> SHIFT_12;
+        }
+        spin_unlock(&cow_lock);
+        pte.rw = 1;
+        pte.avl_3 &= ~PTE_COW;
+    } else {
+        spin_unlock_irqrestore(&mm->lock, flags);
+        return -1;
+    }
+    set_pte(mm->table, addr & ~(PAGE_SIZE - 1), pte);
+    spin_unlock_irqrestore(&mm->lock, flags);
+    return 0;
+}
+
+// Description: moves the end of the heap
+// Inputs: mm - the loaded address space
+//         new_brk - new end of the heap
+// Outputs: 0 on success, -1 if new_brk is below the heap or inside the stack range
+// Effects: growing only moves brk, pages wholly above a lower brk are freed
+int32_t user_mem_brk(user_mem_t* mm, uint32_t new_brk){
+    page_table_entry_t pte, none;
+    uint32_t addr, flags;
+
+    if(new_brk < mm->heap_start || new_brk > USER_STACK_LIMIT){
+        return -1;
+    }
+
+    spin_lock_irqsave(&mm->lock, flags);
+    memset(&none, 0, sizeof(none));
+    for(addr = PAGE_ALIGN_UP(new_brk); addr < PAGE_ALIGN_UP(mm->brk); addr += PAGE_SIZE){
+        pte = mm->table[USER_PTE_IDX(addr)];
+        if(!pte.present){
+            continue;
+        }
+        set_pte(mm->table, addr, none);
+        spin_lock(&cow_lock);
+        put_pages(pte.addy << SHIFT_12, ORDER_4KB);
+        spin_unlock(&cow_lock);
+        mm->resident--;
+    }
+    mm->brk = new_brk;
+    spin_unlock_irqrestore(&mm->lock, flags);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// user address space header file
+#ifndef _USER_MEM_H
+#define _USER_MEM_H
+
+#include "types.h"
+#include "paging.h"
+#include "buddy.h"
+#include "spinlock.h"
+
+// user programs live in one page directory entry, mapped with 4KB pages
+#define USER_START      0x08000000
+#define USER_END        0x08400000
+#define USER_PDE_IDX    (USER_START >> SHIFT_22)
+// programs are linked to run from here
+#define USER_IMAGE_START 0x08048000
+// the stack grows down from USER_END, the heap may not grow into this range
+#define USER_STACK_MAX  0x100000
+#define USER_STACK_LIMIT (USER_END - USER_STACK_MAX)
+
+// page fault error code bits
+#define PF_PRESENT      0x1
+#define PF_WRITE        0x2
+
+// avl_3 bit of a user page table entry
+// set on pages shared after fork, they are read-only until the first write copies them
+#define PTE_COW         0x1
+
+#define PAGE_ALIGN_UP(addr) (((addr) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+
+// the user part of an address space
+// pages between USER_IMAGE_START and brk, and in the stack range, are only
+// allocated when they are first touched and start out zero-filled
+typedef struct user_mem_t {
+    page_table_entry_t* table;
+    uint32_t heap_start;
+    uint32_t brk;
+    // number of pages mapped in table
+    uint32_t resident;
+    // protects table, brk and resident, taken before cow_lock
+    spinlock_t lock;
+} user_mem_t;
+
+// sets up an empty address space whose image ends at image_end
+// returns 0, or -1 if there is no memory for the page table
+extern int32_t user_mem_init(user_mem_t* mm, uint32_t image_end);
+
+// drops every page and the page table
+extern void user_mem_free(user_mem_t* mm);
+
+// points the user entry of pd at mm's page table
+extern void user_mem_install(user_mem_t* mm, page_directory_entry_t* pd);
+
+// makes child a copy-on-write copy of parent, parent must be the loaded address space
+// returns 0, or -1 if there is no memory for the page table
+extern int32_t user_mem_fork(user_mem_t* child, user_mem_t* parent);
+
+// maps the page holding addr in an address space that is not loaded
+// returns the page's kernel address, or 0 if there is no memory
+extern uint32_t user_mem_map(user_mem_t* mm, uint32_t addr);
+
+// handles a page fault at addr in the loaded address space mm
+// returns 0 if the access can be retried, -1 if it is a real fault
+extern int32_t user_mem_fault(user_mem_t* mm, uint32_t addr, uint32_t error_code);
+
+// moves the end of the heap, pages above the new end are freed
+// returns 0, or -1 if new_brk is out of range
+extern int32_t user_mem_brk(user_mem_t* mm, uint32_t new_brk);
+
+#endif /* _USER_MEM_H */
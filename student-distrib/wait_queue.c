@@ -0,0 +1,104 @@
+// wait queues
+// drivers put a process to sleep here instead of spinning, the interrupt
+// handler that produces the event wakes it up again
+
+#include "wait_queue.h"
+#include "systemcall.h"
+
+// Description: sets up an empty queue
+// Inputs: wq - queue to set up
+// Outputs: none
+// Effects: none
+void wq_init(wait_queue_t* wq){
+    spin_init(&wq->lock);
+    wq->head = wq->tail = NULL;
+}
+
+// Description: blocks the running process until it is woken up
+// Inputs: wq - queue to sleep on
+// Outputs: none
+// Effects: other processes run in the meantime, wq->lock is dropped while we sleep
+void wq_sleep(wait_queue_t* wq){
+    pcb_t* pcb = current_pcb();
+
+    // the idle task has nothing else to do, it can only wait for the next interrupt
+    if(pcb == NULL){
+        spin_unlock(&wq->lock);
+        // sti only takes effect after hlt, so no interrupt slips in between
+        asm volatile("sti; hlt; cli");
+        spin_lock(&wq->lock);
+        return;
+    }
+
+    pcb->wait_next = NULL;
+    pcb->wait_queue = wq;
+    if(wq->tail == NULL){
+        wq->head = pcb;
+    } else {
+        wq->tail->wait_next = pcb;
+    }
+    wq->tail = pcb;
+    pcb->state = PROC_BLOCKED;
+    // a wakeup from here on finds us on the queue, sched_wakeup copes with
+    // us still being on the CPU
+    spin_unlock(&wq->lock);
+    schedule();
+    spin_lock(&wq->lock);
+}
+
+// Description: makes every process on a queue runnable
+// Inputs: wq - queue to empty
+// Outputs: none
+// Effects: the processes run once the scheduler picks them
+void wq_wake_all(wait_queue_t* wq){
+    uint32_t flags;
+    pcb_t* pcb;
+
+    spin_lock_irqsave(&wq->lock, flags);
+    for(pcb = wq->head; pcb != NULL; pcb = pcb->wait_next){
+        pcb->wait_queue = NULL;
+        sched_wakeup(pcb);
+    }
+    wq->head = wq->tail = NULL;
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+// Description: takes one process off the queue it sleeps on
+// Inputs: pcb - process to wake up
+// Outputs: none
+// Effects: does nothing if the process is not blocked
+void wq_wake_process(pcb_t* pcb){
+    uint32_t flags;
+    wait_queue_t* wq;
+    pcb_t* prev;
+
+    cli_and_save(flags);
+    while(1){
+        wq = pcb->wait_queue;
+        if(pcb->state != PROC_BLOCKED || wq == NULL){
+            restore_flags(flags);
+            return;
+        }
+        spin_lock(&wq->lock);
+        // someone else may have woken it while we waited for the lock
+        if(pcb->wait_queue == wq){
+            break;
+        }
+        spin_unlock(&wq->lock);
+    }
+
+    if(wq->head == pcb){
+        wq->head = pcb->wait_next;
+        prev = NULL;
+    } else {
+        for(prev = wq->head; prev->wait_next != pcb; prev = prev->wait_next);
+        prev->wait_next = pcb->wait_next;
+    }
+    if(wq->tail == pcb){
+        wq->tail = prev;
+    }
+    pcb->wait_queue = NULL;
+    sched_wakeup(pcb);
+    spin_unlock(&wq->lock);
+    restore_flags(flags);
+}
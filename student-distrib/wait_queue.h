@@ -0,0 +1,47 @@
+// wait queue header file
+#ifndef _WAIT_QUEUE_H
+#define _WAIT_QUEUE_H
+
+#include "types.h"
+#include "spinlock.h"
+
+struct pcb_t;
+
+// processes blocked until some event, woken in the order they went to sleep
+// a process is on a queue exactly while its state is PROC_BLOCKED
+typedef struct wait_queue_t {
+    // protects the queue, and whatever condition its sleepers wait for
+    spinlock_t lock;
+    struct pcb_t* head;
+    struct pcb_t* tail;
+} wait_queue_t;
+
+// sets up an empty queue
+extern void wq_init(wait_queue_t* wq);
+
+// blocks the running process on wq until it is woken up
+// the caller holds wq->lock with interrupts off, so a wakeup cannot come between
+// checking the condition and going to sleep, it holds it again when this returns
+extern void wq_sleep(wait_queue_t* wq);
+
+// makes every process on wq runnable, safe to call from interrupt handlers
+extern void wq_wake_all(wait_queue_t* wq);
+
+// takes a blocked process off its queue and makes it runnable
+extern void wq_wake_process(struct pcb_t* pcb);
+
+// returns 1 if the running process was killed, it should stop waiting
+extern int32_t process_killed(void);
+
+// blocks the running process on wq until cond is true, or until it is killed
+#define wait_event(wq, cond)            \
+do {                                    \
+    uint32_t _wq_flags;                 \
+    spin_lock_irqsave(&(wq)->lock, _wq_flags); \
+    while (!(cond) && !process_killed()) { \
+        wq_sleep(wq);                   \
+    }                                   \
+    spin_unlock_irqrestore(&(wq)->lock, _wq_flags); \
+} while (0)
+
+#endif /* _WAIT_QUEUE_H */
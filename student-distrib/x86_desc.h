@@ -15,6 +15,11 @@
 #define USER_DS     0x002B
 #define KERNEL_TSS  0x0030
 #define KERNEL_LDT  0x0038
+/* TSS of the other CPUs, one selector after another starting here */
+#define AP_TSS      0x0040
+
+/* Most CPUs we bring up, each one needs a TSS in the GDT */
+#define NR_CPUS     4
 
 /* Size of the task state segment (TSS) */
 #define TSS_SIZE    104
@@ -123,6 +128,8 @@ extern uint32_t ldt;
 extern uint32_t tss_size;
 extern seg_desc_t tss_desc_ptr;
 extern tss_t tss;
+/* TSS entries of CPUs 1 to NR_CPUS - 1 */
+extern seg_desc_t ap_tss_desc_ptr[NR_CPUS - 1];
 
 /* Sets runtime-settable parameters in the GDT entry for the LDT */
 #define SET_LDT_PARAMS(str, addr, lim)                          \
@@ -0,0 +1,80 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/* with 1000 rounds the microseconds they take are the nanoseconds one takes */
+#define ROUNDS 1000
+#define FORK_ROUNDS 100
+#define NS_PER_US 1000
+#define US_PER_SEC 1000000
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* microseconds from start to end, the runs here take seconds at most */
+static uint32_t elapsed_us (const timespec_t* start, const timespec_t* end)
+{
+    uint32_t sec = end->sec - start->sec;
+    int32_t nsec = (int32_t)end->nsec - (int32_t)start->nsec;
+
+    if (nsec < 0) {
+        sec--;
+        nsec += NS_PER_SEC;
+    }
+    return sec * US_PER_SEC + nsec / NS_PER_US;
+}
+
+static void report (const char* what, uint32_t value, const char* unit)
+{
+    ece391_fdputs (1, (uint8_t*)what);
+    print_num (value);
+    ece391_fdputs (1, (uint8_t*)unit);
+}
+
+int main ()
+{
+    int32_t i, pid, status;
+    timespec_t start, end;
+
+    if (-1 == ece391_clock_gettime (CLOCK_MONOTONIC, &start)) {
+        ece391_fdputs (1, (uint8_t*)"clock_gettime failed\n");
+        return 2;
+    }
+
+    /* the cheapest system call there is, the clock itself */
+    for (i = 0; i < ROUNDS; i++)
+        ece391_clock_gettime (CLOCK_MONOTONIC, &end);
+    report ("clock_gettime: ", elapsed_us (&start, &end), " ns\n");
+
+    /* the same clock read from the time page, without trapping */
+    ece391_clock_read (&start);
+    for (i = 0; i < ROUNDS; i++)
+        ece391_clock_read (&end);
+    report ("clock_read: ", elapsed_us (&start, &end), " ns\n");
+
+    ece391_clock_gettime (CLOCK_MONOTONIC, &start);
+    for (i = 0; i < ROUNDS; i++)
+        ece391_yield ();
+    ece391_clock_gettime (CLOCK_MONOTONIC, &end);
+    report ("yield: ", elapsed_us (&start, &end), " ns\n");
+
+    ece391_clock_gettime (CLOCK_MONOTONIC, &start);
+    for (i = 0; i < FORK_ROUNDS; i++) {
+        if (-1 == (pid = ece391_fork ())) {
+            ece391_fdputs (1, (uint8_t*)"fork failed\n");
+            return 3;
+        }
+        if (0 == pid)
+            return 0;
+        ece391_waitpid (pid, &status, 0);
+    }
+    ece391_clock_gettime (CLOCK_MONOTONIC, &end);
+    report ("fork + exit + waitpid: ", elapsed_us (&start, &end) / FORK_ROUNDS, " us\n");
+    return 0;
+}
@@ -3,30 +3,32 @@
 #include "ece391support.h"
 #include "ece391syscall.h"
 
-int main ()
+int main (int argc, char* argv[])
 {
-    int32_t fd, cnt;
+    int32_t fd, cnt, i;
     uint8_t buf[1024];
 
-    if (0 != ece391_getargs (buf, 1024)) {
+    if (argc < 2) {
         ece391_fdputs (1, (uint8_t*)"could not read arguments\n");
 	return 3;
     }
 
-    if (-1 == (fd = ece391_open (buf))) {
-        ece391_fdputs (1, (uint8_t*)"file not found\n");
-	return 2;
-    }
+    for (i = 1; i < argc; i++) {
+	if (-1 == (fd = ece391_open ((uint8_t*)argv[i]))) {
+	    ece391_fdputs (1, (uint8_t*)"file not found\n");
+	    return 2;
+	}
 
-    while (0 != (cnt = ece391_read (fd, buf, 1024))) {
-        if (-1 == cnt) {
-	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
-	    return 3;
+	while (0 != (cnt = ece391_read (fd, buf, 1024))) {
+	    if (-1 == cnt) {
+		ece391_fdputs (1, (uint8_t*)"file read failed\n");
+		return 3;
+	    }
+	    if (-1 == ece391_write (1, buf, cnt))
+		return 3;
 	}
-	if (-1 == ece391_write (1, buf, cnt))
-	    return 3;
+	ece391_close (fd);
     }
 
     return 0;
 }
-
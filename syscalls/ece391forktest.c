@@ -0,0 +1,49 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/* lives in the shared program page, so the child's write forces a copy */
+static int32_t value = 1;
+
+static void print_num (uint32_t num)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (num, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+int main ()
+{
+    int32_t pid, status, ret;
+
+    if (-1 == (pid = ece391_fork ())) {
+        ece391_fdputs (1, (uint8_t*)"fork failed\n");
+        return 2;
+    }
+
+    if (0 == pid) {
+        value = 2;
+        ece391_fdputs (1, (uint8_t*)"child sees ");
+        print_num (value);
+        ece391_fdputs (1, (uint8_t*)"\n");
+        return 0;
+    }
+
+    ece391_fdputs (1, (uint8_t*)"parent got child ");
+    print_num (pid);
+    ece391_fdputs (1, (uint8_t*)" and still sees ");
+    print_num (value);
+    ece391_fdputs (1, (uint8_t*)"\n");
+
+    /* poll for the child, handing the CPU over instead of spinning */
+    while (0 == (ret = ece391_waitpid (pid, &status, WNOHANG)))
+        ece391_yield ();
+    if (pid != ret || 0 != status) {
+        ece391_fdputs (1, (uint8_t*)"waitpid failed\n");
+        return 4;
+    }
+    ece391_fdputs (1, (uint8_t*)"child exited with status 0\n");
+    return value == 1 ? 0 : 3;
+}
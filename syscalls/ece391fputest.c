@@ -0,0 +1,62 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define ROUNDS 100
+
+/* x87 control words that differ only in the rounding mode */
+#define CW_ROUND_DOWN 0x077F
+#define CW_ROUND_UP   0x0B7F
+
+static uint16_t get_cw (void)
+{
+    uint16_t cw;
+
+    asm volatile ("fnstcw %0" : "=m" (cw));
+    return cw;
+}
+
+/* 
+ * sets the rounding mode, then keeps checking that another process using
+ * the FPU in between does not change it or the result of a division
+ */
+static int32_t check_fpu (uint16_t cw)
+{
+    int32_t i;
+    volatile double one = 1.0, three = 3.0, third;
+
+    asm volatile ("fldcw %0" : : "m" (cw));
+    third = one / three;
+    for (i = 0; i < ROUNDS; i++) {
+        ece391_yield ();
+        if (get_cw () != cw || one / three != third)
+            return -1;
+    }
+    return 0;
+}
+
+int main ()
+{
+    int32_t pid, status;
+
+    if (-1 == (pid = ece391_fork ())) {
+        ece391_fdputs (1, (uint8_t*)"fork failed\n");
+        return 2;
+    }
+
+    if (0 == pid)
+        return (0 == check_fpu (CW_ROUND_UP)) ? 0 : 3;
+
+    if (-1 == check_fpu (CW_ROUND_DOWN)) {
+        ece391_fdputs (1, (uint8_t*)"parent FPU state was clobbered\n");
+        ece391_waitpid (pid, &status, 0);
+        return 3;
+    }
+    if (pid != ece391_waitpid (pid, &status, 0) || 0 != status) {
+        ece391_fdputs (1, (uint8_t*)"child FPU state was clobbered\n");
+        return 3;
+    }
+    ece391_fdputs (1, (uint8_t*)"FPU state survived context switches\n");
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+int main ()
+{
+    int32_t i, j;
+    irq_stats_t stats[NUM_IRQS];
+
+    if (-1 == ece391_kstat (KSTAT_IRQ, stats, sizeof (stats))) {
+        ece391_fdputs (1, (uint8_t*)"could not read interrupt statistics\n");
+        return 2;
+    }
+
+    ece391_fdputs (1, (uint8_t*)"irq: count max-cycles, interrupts-off histogram\n");
+    for (i = 0; i < NUM_IRQS; i++) {
+        if (0 == stats[i].count)
+            continue;
+        print_num (i);
+        ece391_fdputs (1, (uint8_t*)": ");
+        print_num (stats[i].count);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (stats[i].max_cycles);
+        ece391_fdputs (1, (uint8_t*)"\n   ");
+        /* each non-empty bucket prints as log2(cycles):count */
+        for (j = 0; j < SYSSTAT_BUCKETS; j++) {
+            if (0 == stats[i].hist[j])
+                continue;
+            ece391_fdputs (1, (uint8_t*)" 2^");
+            print_num (j);
+            ece391_fdputs (1, (uint8_t*)":");
+            print_num (stats[i].hist[j]);
+        }
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/* the idle entries plus one for every pid */
+#define MAX_ENTRIES 65
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* each non-empty bucket prints as log2(us):count */
+static void print_hist (const sched_lat_t* lat)
+{
+    int32_t i;
+
+    ece391_fdputs (1, (uint8_t*)"   ");
+    for (i = 0; i < LAT_BUCKETS; i++) {
+        if (0 == lat->hist[i])
+            continue;
+        ece391_fdputs (1, (uint8_t*)" 2^");
+        print_num (i);
+        ece391_fdputs (1, (uint8_t*)":");
+        print_num (lat->hist[i]);
+    }
+    ece391_fdputs (1, (uint8_t*)"\n");
+}
+
+static void print_pid (int32_t pid)
+{
+    if (PROC_IDLE_PID == pid)
+        ece391_fdputs (1, (uint8_t*)"idle");
+    else
+        print_num (pid);
+}
+
+int main ()
+{
+    static proc_info_t info[MAX_ENTRIES];
+    sched_lat_report_t report;
+    int32_t i, n;
+
+    if (-1 == ece391_kstat (KSTAT_SCHED_LAT, &report, sizeof (report)) ||
+        -1 == (n = ece391_procstat (info, MAX_ENTRIES))) {
+        ece391_fdputs (1, (uint8_t*)"could not read scheduler latencies\n");
+        return 2;
+    }
+
+    ece391_fdputs (1, (uint8_t*)"wakeups: ");
+    print_num (report.all.count);
+    ece391_fdputs (1, (uint8_t*)", max ");
+    print_num (report.all.max_us);
+    ece391_fdputs (1, (uint8_t*)" us\n");
+    print_hist (&report.all);
+
+    ece391_fdputs (1, (uint8_t*)"pid: wakeups max-us name\n");
+    for (i = 0; i < n; i++) {
+        if (0 == info[i].sched_lat.count)
+            continue;
+        print_num (info[i].pid);
+        ece391_fdputs (1, (uint8_t*)": ");
+        print_num (info[i].sched_lat.count);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (info[i].sched_lat.max_us);
+        ece391_fdputs (1, (uint8_t*)" ");
+        ece391_fdputs (1, (uint8_t*)info[i].name);
+        ece391_fdputs (1, (uint8_t*)"\n");
+        print_hist (&info[i].sched_lat);
+    }
+
+    ece391_fdputs (1, (uint8_t*)"worst: us pid name tick level cpu(woken on) after\n");
+    for (i = 0; i < LAT_TRACES && 0 != report.worst[i].latency_us; i++) {
+        print_num (report.worst[i].latency_us);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (report.worst[i].pid);
+        ece391_fdputs (1, (uint8_t*)" ");
+        ece391_fdputs (1, (uint8_t*)report.worst[i].name);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (report.worst[i].ticks);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (report.worst[i].priority);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (report.worst[i].cpu);
+        ece391_fdputs (1, (uint8_t*)"(");
+        print_num (report.worst[i].wake_cpu);
+        ece391_fdputs (1, (uint8_t*)") ");
+        print_pid (report.worst[i].prev_pid);
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define MAX_CACHES 16
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+int main ()
+{
+    int32_t i, cnt;
+    kmem_stat_t stats[MAX_CACHES];
+    tlb_stats_t tlb;
+
+    if (-1 == (cnt = ece391_kstat (KSTAT_KMEM, stats, sizeof (stats)))) {
+        ece391_fdputs (1, (uint8_t*)"could not read kernel heap statistics\n");
+        return 2;
+    }
+
+    ece391_fdputs (1, (uint8_t*)"cache: objsize active/total slabs avg-request\n");
+    for (i = 0; i < cnt / (int32_t)sizeof (kmem_stat_t); i++) {
+        ece391_fdputs (1, (uint8_t*)stats[i].name);
+        ece391_fdputs (1, (uint8_t*)": ");
+        print_num (stats[i].obj_size);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (stats[i].active_objs);
+        ece391_fdputs (1, (uint8_t*)"/");
+        print_num (stats[i].total_objs);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (stats[i].slabs);
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (stats[i].allocs ? stats[i].bytes_requested / stats[i].allocs : 0);
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+
+    if (-1 != ece391_kstat (KSTAT_TLB, &tlb, sizeof (tlb))) {
+        ece391_fdputs (1, (uint8_t*)"tlb: full flushes ");
+        print_num (tlb.full_flushes);
+        ece391_fdputs (1, (uint8_t*)", cr3 loads ");
+        print_num (tlb.cr3_loads);
+        ece391_fdputs (1, (uint8_t*)", invlpg ");
+        print_num (tlb.invlpgs);
+        ece391_fdputs (1, (uint8_t*)", flushes avoided ");
+        print_num (tlb.flushes_avoided);
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+
+    return 0;
+}
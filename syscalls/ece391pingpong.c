@@ -11,6 +11,9 @@
 #define LOOPMAX BUFMAX-ENDING-1
 #define STARTCHAR 'A'
 #define ENDCHAR 'Z'
+/* one frame per interrupt of the 32 Hz RTC, drawing one takes far less */
+#define FRAME_US 31250
+#define FRAME_BUDGET_US 2000
 
 int main ()
 {
@@ -37,6 +40,8 @@ int main ()
     rtc_fd = ece391_open((uint8_t*)"rtc");
     ret_val = 32;
     ret_val = ece391_write(rtc_fd, &ret_val, 4);
+    // keep the frame rate under load, without a reservation we still run
+    ece391_sched_deadline(FRAME_US, FRAME_BUDGET_US);
 
     while(1)
     {
@@ -0,0 +1,64 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* returns the value of a decimal string, or 0 if it is not one */
+static uint32_t parse_num (const char* str)
+{
+    uint32_t i, value = 0;
+
+    for (i = 0; '\0' != str[i]; i++) {
+        if (str[i] < '0' || str[i] > '9')
+            return 0;
+        value = value * 10 + (str[i] - '0');
+    }
+    return value;
+}
+
+int main (int argc, char* argv[])
+{
+    int32_t i;
+    sched_tunables_t tunables;
+
+    if (-1 == ece391_schedctl (SCHED_GET, &tunables, sizeof (tunables)))
+        return 2;
+
+    /* arguments: q0 ... q3 [boost_interval [io_boost]] */
+    if (argc > 1) {
+        if (argc < SCHED_LEVELS + 1 || argc > SCHED_LEVELS + 3) {
+            ece391_fdputs (1, (uint8_t*)"usage: schedtune [q0 q1 q2 q3 [boost [ioboost]]]\n");
+            return 3;
+        }
+        for (i = 0; i < SCHED_LEVELS; i++)
+            tunables.quantum[i] = parse_num (argv[i + 1]);
+        if (argc > SCHED_LEVELS + 1)
+            tunables.boost_interval = parse_num (argv[SCHED_LEVELS + 1]);
+        if (argc > SCHED_LEVELS + 2)
+            tunables.io_boost = parse_num (argv[SCHED_LEVELS + 2]);
+        if (-1 == ece391_schedctl (SCHED_SET, &tunables, sizeof (tunables))) {
+            ece391_fdputs (1, (uint8_t*)"invalid tunables\n");
+            return 2;
+        }
+    }
+
+    ece391_fdputs (1, (uint8_t*)"quanta (ticks):");
+    for (i = 0; i < SCHED_LEVELS; i++) {
+        ece391_fdputs (1, (uint8_t*)" ");
+        print_num (tunables.quantum[i]);
+    }
+    ece391_fdputs (1, (uint8_t*)"\nboost interval (ticks): ");
+    print_num (tunables.boost_interval);
+    ece391_fdputs (1, (uint8_t*)"\nio boost (levels): ");
+    print_num (tunables.io_boost);
+    ece391_fdputs (1, (uint8_t*)"\n");
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* returns the value of a decimal string, or 0 if it is not one */
+static uint32_t parse_num (const char* str)
+{
+    uint32_t i, value = 0;
+
+    for (i = 0; '\0' != str[i]; i++) {
+        if (str[i] < '0' || str[i] > '9')
+            return 0;
+        value = value * 10 + (str[i] - '0');
+    }
+    return value;
+}
+
+/* percent of total that part is, total is not 0 */
+static uint32_t percent (uint32_t part, uint32_t total)
+{
+    /* keep part * 100 within 32 bits */
+    while (total > 0xFFFFFFFF / 100) {
+        part >>= 1;
+        total >>= 1;
+    }
+    return (part * 100 + total / 2) / total;
+}
+
+int main (int argc, char* argv[])
+{
+    int32_t i;
+    uint32_t total_share = 0, total_ticks = 0;
+    sched_tunables_t tunables;
+    fair_stat_t stats[SCHED_GROUPS];
+
+    if (-1 == ece391_schedctl (SCHED_GET, &tunables, sizeof (tunables)))
+        return 2;
+
+    /* arguments: one share per terminal */
+    if (argc > 1) {
+        if (argc != SCHED_GROUPS + 1) {
+            ece391_fdputs (1, (uint8_t*)"usage: shares [share0 share1 share2]\n");
+            return 3;
+        }
+        for (i = 0; i < SCHED_GROUPS; i++)
+            tunables.share[i] = parse_num (argv[i + 1]);
+        if (-1 == ece391_schedctl (SCHED_SET, &tunables, sizeof (tunables))) {
+            ece391_fdputs (1, (uint8_t*)"invalid shares\n");
+            return 2;
+        }
+    }
+
+    if (-1 == ece391_kstat (KSTAT_FAIR_SHARE, stats, sizeof (stats)))
+        return 2;
+    for (i = 0; i < SCHED_GROUPS; i++) {
+        total_share += stats[i].share;
+        total_ticks += stats[i].ticks;
+    }
+
+    ece391_fdputs (1, (uint8_t*)"terminal: share (%) ticks used (%)\n");
+    for (i = 0; i < SCHED_GROUPS; i++) {
+        print_num (i);
+        ece391_fdputs (1, (uint8_t*)": ");
+        print_num (stats[i].share);
+        ece391_fdputs (1, (uint8_t*)" (");
+        print_num (percent (stats[i].share, total_share));
+        ece391_fdputs (1, (uint8_t*)") ");
+        print_num (stats[i].ticks);
+        ece391_fdputs (1, (uint8_t*)" (");
+        print_num (total_ticks ? percent (stats[i].ticks, total_ticks) : 0);
+        ece391_fdputs (1, (uint8_t*)")\n");
+    }
+    return 0;
+}
@@ -5,13 +5,36 @@
 
 #define BUFSIZE 1024
 
+static void print_num (uint32_t num)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (num, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* report background jobs that have finished since the last prompt */
+static void reap_jobs ()
+{
+    int32_t pid, status;
+
+    while (0 < (pid = ece391_waitpid (-1, &status, WNOHANG))) {
+	ece391_fdputs (1, (uint8_t*)"[");
+	print_num (pid);
+	ece391_fdputs (1, (uint8_t*)"] done, status ");
+	print_num (status);
+	ece391_fdputs (1, (uint8_t*)"\n");
+    }
+}
+
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, pid, bg;
     uint8_t buf[BUFSIZE];
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
     while (1) {
+	reap_jobs ();
         ece391_fdputs (1, (uint8_t*)"391OS> ");
 	if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
 	    ece391_fdputs (1, (uint8_t*)"read from keyboard failed\n");
@@ -22,8 +45,31 @@ int main ()
 	buf[cnt] = '\0';
 	if (0 == ece391_strcmp (buf, (uint8_t*)"exit"))
 	    return 0;
+	/* a trailing '&' runs the command in the background */
+	while (cnt > 0 && ' ' == buf[cnt - 1])
+	    buf[--cnt] = '\0';
+	bg = (cnt > 0 && '&' == buf[cnt - 1]);
+	if (bg) {
+	    buf[--cnt] = '\0';
+	    while (cnt > 0 && ' ' == buf[cnt - 1])
+		buf[--cnt] = '\0';
+	}
 	if ('\0' == buf[0])
 	    continue;
+	if (bg) {
+	    if (-1 == (pid = ece391_fork ())) {
+		ece391_fdputs (1, (uint8_t*)"fork failed\n");
+		continue;
+	    }
+	    if (0 == pid) {
+		rval = ece391_execute (buf);
+		ece391_halt (-1 == rval ? 1 : rval);
+	    }
+	    ece391_fdputs (1, (uint8_t*)"[");
+	    print_num (pid);
+	    ece391_fdputs (1, (uint8_t*)"]\n");
+	    continue;
+	}
 	rval = ece391_execute (buf);
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
@@ -0,0 +1,26 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+int main (int argc, char* argv[])
+{
+    int32_t i, ms = 0;
+
+    /* argument: how many milliseconds to sleep */
+    if (argc != 2 || '\0' == argv[1][0]) {
+        ece391_fdputs (1, (uint8_t*)"usage: sleep <milliseconds>\n");
+        return 3;
+    }
+    for (i = 0; '\0' != argv[1][i]; i++) {
+        if (argv[1][i] < '0' || argv[1][i] > '9') {
+            ece391_fdputs (1, (uint8_t*)"usage: sleep <milliseconds>\n");
+            return 3;
+        }
+        ms = ms * 10 + (argv[1][i] - '0');
+    }
+
+    if (-1 == ece391_sleep (ms))
+        return 2;
+    return 0;
+}
@@ -102,3 +102,43 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+static const time_page_t* const time_page = (const time_page_t*)TIME_PAGE;
+
+static uint64_t rdtsc (void)
+{
+    uint64_t val;
+
+    asm volatile ("rdtsc" : "=A" (val));
+    return val;
+}
+
+uint32_t ece391_ticks(void)
+{
+    return time_page->ticks;
+}
+
+/* 
+ * same as ece391_clock_gettime (CLOCK_MONOTONIC, ts), the kernel's
+ * conversion done here: the two halves of the cycle count are scaled
+ * apart so nothing overflows, and divl splits off the seconds without
+ * needing libgcc
+ */
+int32_t ece391_clock_read(struct timespec* ts)
+{
+    uint64_t cycles, ns;
+    uint32_t shift = time_page->shift, mult = time_page->mult;
+    uint32_t ns_per_sec = NS_PER_SEC;
+
+    if (0 == time_page->tsc_per_tick) {
+        ns = (uint64_t)time_page->ticks * TIME_NS_PER_TICK;
+    } else {
+        cycles = rdtsc () - (((uint64_t)time_page->tsc_base_hi << 32) | time_page->tsc_base_lo);
+        ns = (((uint64_t)(uint32_t)(cycles >> 32) * mult) << (32 - shift)) +
+             (((uint64_t)(uint32_t)cycles * mult) >> shift);
+    }
+    asm ("divl %4"
+         : "=a" (ts->sec), "=d" (ts->nsec)
+         : "a" ((uint32_t)ns), "d" ((uint32_t)(ns >> 32)), "rm" (ns_per_sec)
+         : "cc");
+    return 0;
+}
@@ -9,5 +9,10 @@ extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
 
+/* read the kernel's time page, no system call involved */
+struct timespec;
+extern uint32_t ece391_ticks(void);
+extern int32_t ece391_clock_read(struct timespec* ts);
+
 #endif /* ECE391SUPPORT_H */
 
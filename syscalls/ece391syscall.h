@@ -21,6 +21,16 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+extern int32_t ece391_sysstat (int32_t pid, void* buf, int32_t nbytes);
+extern int32_t ece391_kstat (int32_t which, void* buf, int32_t nbytes);
+extern int32_t ece391_fork (void);
+extern void* ece391_sbrk (int32_t increment);
+extern int32_t ece391_waitpid (int32_t pid, int32_t* status, int32_t options);
+extern int32_t ece391_sleep (int32_t ms);
+extern int32_t ece391_yield (void);
+
+/* ece391_waitpid option: return 0 instead of blocking if no child has exited */
+#define WNOHANG 1
 
 enum signums {
 	DIV_ZERO = 0,
@@ -31,5 +41,229 @@ enum signums {
 	NUM_SIGNALS
 };
 
+/* 
+ * Layout filled in by ece391_sysstat.  Arrays are indexed by system call
+ * number - 1; bucket i of a histogram counts calls that took between
+ * 2^i and 2^(i+1) TSC cycles.  Pass SYSSTAT_GLOBAL as the pid to get the
+ * numbers for every process combined.
+ */
+#define NUM_SYSCALLS 21
+#define SYSSTAT_BUCKETS 32
+#define SYSSTAT_GLOBAL -1
+
+typedef struct syscall_stats {
+	uint32_t calls[NUM_SYSCALLS];
+	uint32_t hist[NUM_SYSCALLS][SYSSTAT_BUCKETS];
+} syscall_stats_t;
+
+/*
+ * ece391_kstat(KSTAT_KMEM, ...) fills an array of kmem_stat_t, one per
+ * kernel slab cache, and returns the number of bytes written.
+ */
+#define KSTAT_KMEM 0
+#define CACHE_NAME_LEN 16
+
+typedef struct kmem_stat {
+	int8_t name[CACHE_NAME_LEN];
+	uint32_t obj_size;
+	uint32_t objs_per_slab;
+	uint32_t slabs;
+	uint32_t active_objs;
+	uint32_t total_objs;
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t bytes_requested;
+	uint32_t slab_waste;
+} kmem_stat_t;
+
+/*
+ * ece391_kstat(KSTAT_TLB, ...) fills a tlb_stats_t with counts of full
+ * TLB flushes, address space switches and single-page invalidations.
+ */
+#define KSTAT_TLB 1
+
+typedef struct tlb_stats {
+	uint32_t full_flushes;
+	uint32_t cr3_loads;
+	uint32_t invlpgs;
+	uint32_t flushes_avoided;
+} tlb_stats_t;
+
+/*
+ * ece391_kstat(KSTAT_IRQ, ...) fills an array of NUM_IRQS irq_stats_t, one
+ * per interrupt line, with how long its handler kept interrupts disabled.
+ * Bucket i of hist counts handlers that took between 2^i and 2^(i+1) cycles.
+ */
+#define KSTAT_IRQ 2
+#define NUM_IRQS 16
+
+typedef struct irq_stats {
+	uint32_t count;
+	uint32_t max_cycles;
+	uint32_t hist[SYSSTAT_BUCKETS];
+} irq_stats_t;
+
+/*
+ * ece391_kstat(KSTAT_SCHED_LAT, ...) fills a sched_lat_report_t with how
+ * long processes waited between becoming runnable (created or woken up)
+ * and getting a CPU.  Bucket i of hist counts waits of 2^i to 2^(i+1)
+ * microseconds, the last bucket everything longer.  worst holds the
+ * LAT_TRACES longest waits, worst first: the CPU that woke the process,
+ * the one it ran on, the level it ran at and the process it took the CPU
+ * from (PROC_IDLE_PID for the idle task).  Entries with a latency of 0
+ * are unused.  Each proc_info_t has the same histogram for one process.
+ */
+#define KSTAT_SCHED_LAT 3
+#define LAT_BUCKETS 20
+#define LAT_TRACES 8
+#define LAT_NAME_LEN 16
+
+typedef struct sched_lat {
+	uint32_t count;
+	uint32_t max_us;
+	uint32_t hist[LAT_BUCKETS];
+} sched_lat_t;
+
+typedef struct lat_trace {
+	int32_t pid;
+	int8_t name[LAT_NAME_LEN];
+	uint32_t latency_us;
+	uint32_t ticks;
+	uint32_t priority;
+	uint32_t wake_cpu;
+	uint32_t cpu;
+	int32_t prev_pid;
+} lat_trace_t;
+
+typedef struct sched_lat_report {
+	sched_lat_t all;
+	lat_trace_t worst[LAT_TRACES];
+} sched_lat_report_t;
+
+/*
+ * ece391_kstat(KSTAT_FAIR_SHARE, ...) fills an array of SCHED_GROUPS
+ * fair_stat_t, one per terminal: its CPU share (see ece391_schedctl) and
+ * the ticks its processes have run since boot.
+ */
+#define KSTAT_FAIR_SHARE 4
+
+typedef struct fair_stat {
+	uint32_t share;
+	uint32_t ticks;
+} fair_stat_t;
+
+/*
+ * ece391_procstat fills an array of proc_info_t and returns the number of
+ * entries used.  The first entry is the idle context (pid PROC_IDLE_PID).
+ * Ticks are 20 ms PIT ticks that found the process running, cycles are TSC
+ * cycles it ran for.  nvcsw counts switches because it blocked or exited,
+ * nivcsw switches while it could have kept running.
+ */
+#define PROC_IDLE_PID -1
+#define PROC_NAME_LEN 33
+#define PROC_KTHREAD_TERMINAL -1
+
+/* values of state */
+#define PROC_NEW      0
+#define PROC_RUNNABLE 1
+#define PROC_BLOCKED  2
+#define PROC_ZOMBIE   3
+#define PROC_DEAD     4
+
+typedef struct proc_info {
+	int32_t pid;
+	int32_t parent_pid;
+	int32_t terminal;
+	uint32_t state;
+	int8_t name[PROC_NAME_LEN];
+	uint32_t user_ticks;
+	uint32_t kernel_ticks;
+	uint32_t cycles_lo;
+	uint32_t cycles_hi;
+	uint32_t nvcsw;
+	uint32_t nivcsw;
+	uint32_t priority;
+	uint32_t syscalls;
+	sched_lat_t sched_lat;
+} proc_info_t;
+
+extern int32_t ece391_procstat (proc_info_t* buf, int32_t count);
+
+/*
+ * ece391_schedctl(SCHED_GET, ...) fills a sched_tunables_t with the
+ * scheduler settings, ece391_schedctl(SCHED_SET, ...) installs new ones.
+ * Processes start at level 0, the highest.  Running for quantum[level]
+ * ticks moves a process down one level, waking up from blocking moves it
+ * up io_boost levels, and every boost_interval ticks all processes go
+ * back to level 0.  Quanta and boost_interval must be at least 1 and
+ * io_boost less than SCHED_LEVELS.  The processes of each terminal are a
+ * group, and when several groups want the CPU each gets time in
+ * proportion to its share, from 1 to SCHED_MAX_SHARE, whatever number of
+ * processes it runs.  Levels only order the processes within a group.
+ */
+#define SCHED_GET 0
+#define SCHED_SET 1
+#define SCHED_LEVELS 4
+#define SCHED_GROUPS 3
+#define SCHED_MAX_SHARE 10000
+
+typedef struct sched_tunables {
+	uint32_t quantum[SCHED_LEVELS];
+	uint32_t boost_interval;
+	uint32_t io_boost;
+	uint32_t share[SCHED_GROUPS];
+} sched_tunables_t;
+
+extern int32_t ece391_schedctl (int32_t op, sched_tunables_t* buf, int32_t nbytes);
+
+/*
+ * ece391_clock_gettime(CLOCK_MONOTONIC, ...) fills a timespec_t with the
+ * time since boot.  It comes from the TSC, measured against the PIT when
+ * the kernel starts, so it has far better than tick resolution and never
+ * goes backwards.
+ */
+#define CLOCK_MONOTONIC 0
+#define NS_PER_SEC 1000000000
+
+typedef struct timespec {
+	uint32_t sec;
+	uint32_t nsec;
+} timespec_t;
+
+extern int32_t ece391_clock_gettime (int32_t clock_id, timespec_t* ts);
+
+/*
+ * ece391_sched_deadline(period_us, budget_us) asks for budget_us
+ * microseconds of CPU time every period_us microseconds.  Until its budget
+ * runs out in a period, the process runs before every normal process, and
+ * deadline processes run earliest deadline first.  It fails if the budget
+ * does not fit next to the ones already granted: each CPU keeps a tenth
+ * for everyone else.  The period is at most 1 s and the budget at least
+ * 100 us.  A period of 0 goes back to normal scheduling.  Budgets are
+ * enforced on PIT ticks, so a process can overrun by up to 20 ms; the
+ * overrun comes out of its next budget.
+ */
+extern int32_t ece391_sched_deadline (int32_t period_us, int32_t budget_us);
+
+/*
+ * Every process has the kernel's time page mapped read-only at TIME_PAGE,
+ * ece391_clock_read and ece391_ticks in ece391support.c read it without a
+ * system call.  The time since boot in nanoseconds is
+ * (TSC - tsc_base) * mult >> shift, or ticks * TIME_NS_PER_TICK when
+ * tsc_per_tick is 0 because the kernel could not measure the TSC.  Only
+ * ticks changes after boot, once per PIT tick.
+ */
+#define TIME_PAGE 0x08C00000
+#define TIME_NS_PER_TICK 20000000
+
+typedef struct time_page {
+	volatile uint32_t ticks;
+	uint32_t tsc_per_tick;
+	uint32_t tsc_base_lo;
+	uint32_t tsc_base_hi;
+	uint32_t mult;
+	uint32_t shift;
+} time_page_t;
+
 #endif /* ECE391SYSCALL_H */
 
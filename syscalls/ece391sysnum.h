@@ -11,5 +11,16 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_SYSSTAT 11
+#define SYS_KSTAT   12
+#define SYS_FORK    13
+#define SYS_SBRK    14
+#define SYS_WAITPID 15
+#define SYS_SLEEP   16
+#define SYS_YIELD   17
+#define SYS_PROCSTAT 18
+#define SYS_SCHEDCTL 19
+#define SYS_CLOCK_GETTIME 20
+#define SYS_SCHED_DEADLINE 21
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,61 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+static const char* names[NUM_SYSCALLS] = {
+    "halt", "execute", "read", "write", "open", "close",
+    "getargs", "vidmap", "set_handler", "sigreturn", "sysstat", "kstat",
+    "fork", "sbrk", "waitpid", "sleep", "yield", "procstat", "schedctl",
+    "clock_gettime", "sched_deadline"
+};
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+int main ()
+{
+    int32_t i, j, pid = SYSSTAT_GLOBAL;
+    uint8_t buf[BUFSIZE];
+    syscall_stats_t stats;
+
+    /* optional argument: pid to report on instead of the global numbers */
+    if (0 == ece391_getargs (buf, BUFSIZE)) {
+        pid = 0;
+        for (i = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+            pid = pid * 10 + (buf[i] - '0');
+    }
+
+    if (-1 == ece391_sysstat (pid, &stats, sizeof (stats))) {
+        ece391_fdputs (1, (uint8_t*)"no such process\n");
+        return 2;
+    }
+
+    for (i = 0; i < NUM_SYSCALLS; i++) {
+        if (0 == stats.calls[i])
+            continue;
+        ece391_fdputs (1, (uint8_t*)names[i]);
+        ece391_fdputs (1, (uint8_t*)": ");
+        print_num (stats.calls[i]);
+        ece391_fdputs (1, (uint8_t*)" calls\n   ");
+        /* each non-empty bucket prints as log2(cycles):count */
+        for (j = 0; j < SYSSTAT_BUCKETS; j++) {
+            if (0 == stats.hist[i][j])
+                continue;
+            ece391_fdputs (1, (uint8_t*)" 2^");
+            print_num (j);
+            ece391_fdputs (1, (uint8_t*)":");
+            print_num (stats.hist[i][j]);
+        }
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/* the idle entry plus one for every pid */
+#define MAX_ENTRIES 65
+#define INTERVAL_MS 1000
+
+static const char* state_names = "NRBZD";
+
+static void print_num (uint32_t value)
+{
+    uint8_t buf[16];
+
+    ece391_itoa (value, buf, 10);
+    ece391_fdputs (1, buf);
+}
+
+/* right-aligns value in a column of the given width */
+static void print_col (uint32_t value, uint32_t width)
+{
+    uint8_t buf[16];
+    uint32_t len;
+
+    ece391_itoa (value, buf, 10);
+    for (len = ece391_strlen (buf); len < width; len++)
+        ece391_fdputs (1, (uint8_t*)" ");
+    ece391_fdputs (1, buf);
+}
+
+int main (int argc, char* argv[])
+{
+    static proc_info_t info[MAX_ENTRIES];
+    /* ticks seen last round, indexed by pid + 1 so idle fits at 0 */
+    static uint32_t last[MAX_ENTRIES];
+    int32_t i, n, rounds = 0, round;
+    uint32_t ticks, delta, total;
+    uint8_t state[2] = {0, 0};
+
+    /* optional argument: number of updates, forever if there is none */
+    if (argc > 1) {
+        for (i = 0; argv[1][i] >= '0' && argv[1][i] <= '9'; i++)
+            rounds = rounds * 10 + (argv[1][i] - '0');
+    }
+
+    for (round = 0; 0 == rounds || round < rounds; round++) {
+        if (-1 == (n = ece391_procstat (info, MAX_ENTRIES))) {
+            ece391_fdputs (1, (uint8_t*)"could not read process statistics\n");
+            return 2;
+        }
+
+        /* CPU share over the last interval, in PIT ticks */
+        total = 0;
+        for (i = 0; i < n; i++) {
+            ticks = info[i].user_ticks + info[i].kernel_ticks;
+            /* a pid that was reused starts over */
+            total += (ticks >= last[info[i].pid + 1]) ? ticks - last[info[i].pid + 1] : ticks;
+        }
+
+        ece391_fdputs (1, (uint8_t*)"  PID TTY S PRI CPU%  USER   SYS  VCSW IVCSW  CALLS NAME\n");
+        for (i = 0; i < n; i++) {
+            ticks = info[i].user_ticks + info[i].kernel_ticks;
+            delta = (ticks >= last[info[i].pid + 1]) ? ticks - last[info[i].pid + 1] : ticks;
+            last[info[i].pid + 1] = ticks;
+
+            if (PROC_IDLE_PID == info[i].pid)
+                ece391_fdputs (1, (uint8_t*)"    -");
+            else
+                print_col (info[i].pid, 5);
+            if (PROC_KTHREAD_TERMINAL == info[i].terminal)
+                ece391_fdputs (1, (uint8_t*)"   -");
+            else
+                print_col (info[i].terminal + 1, 4);
+            state[0] = state_names[info[i].state < 5 ? info[i].state : 0];
+            ece391_fdputs (1, (uint8_t*)" ");
+            ece391_fdputs (1, state);
+            print_col (info[i].priority, 4);
+            print_col (total ? delta * 100 / total : 0, 5);
+            print_col (info[i].user_ticks, 6);
+            print_col (info[i].kernel_ticks, 6);
+            print_col (info[i].nvcsw, 6);
+            print_col (info[i].nivcsw, 6);
+            print_col (info[i].syscalls, 7);
+            ece391_fdputs (1, (uint8_t*)" ");
+            ece391_fdputs (1, (uint8_t*)info[i].name);
+            ece391_fdputs (1, (uint8_t*)"\n");
+        }
+        ece391_fdputs (1, (uint8_t*)"processes: ");
+        print_num (n - 1);
+        ece391_fdputs (1, (uint8_t*)"\n\n");
+
+        if (0 == rounds || round + 1 < rounds)
+            ece391_sleep (INTERVAL_MS);
+    }
+
+    return 0;
+}